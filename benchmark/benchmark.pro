@@ -0,0 +1,18 @@
+TEMPLATE = app
+TARGET = benchmark
+
+INCLUDEPATH += ../include
+LIBS += -L../lib -ljade
+
+CONFIG += release warn_on console c++11 qt
+CONFIG -= debug app_bundle
+QT += widgets concurrent
+
+!win32:MOC_DIR = release
+!win32:OBJECTS_DIR = release
+!win32:RCC_DIR = release
+
+# --------------------------------------------------------------------------------------------------
+
+SOURCES += \
+	main.cpp
@@ -0,0 +1,104 @@
+/* main.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade application.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+// Measures the time taken by DrawingScene::render() to paint 100000 DrawingLineItems into a
+// QImage with display lists disabled, enabled without batching, and enabled with batching.
+// Build libjade first, then run qmake and make in this directory.
+
+#include <Drawing.h>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <cstdio>
+
+const int numberOfColumns = 400;
+const int numberOfRows = 250;
+const int numberOfRenders = 10;
+
+qreal renderTime(DrawingScene* scene, QImage* image)
+{
+	QRectF sceneRect = scene->sceneRect();
+	QElapsedTimer timer;
+	qint64 elapsedTime = 0;
+
+	// The first render is not timed, so that each item's display list is recorded beforehand
+	for(int renderIndex = 0; renderIndex <= numberOfRenders; renderIndex++)
+	{
+		QPainter painter(image);
+		painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+		painter.scale(image->width() / sceneRect.width(), image->height() / sceneRect.height());
+		painter.translate(-sceneRect.left(), -sceneRect.top());
+
+		timer.start();
+		scene->render(&painter);
+		if (renderIndex > 0) elapsedTime += timer.nsecsElapsed();
+	}
+
+	return elapsedTime / 1.0E6 / numberOfRenders;
+}
+
+int main(int argc, char* argv[])
+{
+	QApplication app(argc, argv);
+
+	DrawingScene scene;
+	QRectF sceneRect = scene.sceneRect();
+	qreal columnWidth = sceneRect.width() / numberOfColumns;
+	qreal rowHeight = sceneRect.height() / numberOfRows;
+
+	// Short horizontal and vertical lines, similar to the wires in a schematic
+	for(int row = 0; row < numberOfRows; row++)
+	{
+		for(int column = 0; column < numberOfColumns; column++)
+		{
+			DrawingLineItem* lineItem = new DrawingLineItem();
+			lineItem->setPosition(sceneRect.left() + column * columnWidth,
+				sceneRect.top() + row * rowHeight);
+
+			if ((row + column) % 2 == 0)
+				lineItem->setLine(0, 0, columnWidth * 0.8, 0);
+			else
+				lineItem->setLine(0, 0, 0, rowHeight * 0.8);
+
+			scene.addItem(lineItem);
+		}
+	}
+
+	QImage image(1100, 850, QImage::Format_ARGB32_Premultiplied);
+
+	scene.setUsesDisplayLists(false);
+	qreal noDisplayListTime = renderTime(&scene, &image);
+
+	scene.setUsesDisplayLists(true);
+	scene.setBatchesDisplayLists(false);
+	qreal displayListTime = renderTime(&scene, &image);
+
+	scene.setBatchesDisplayLists(true);
+	qreal batchedDisplayListTime = renderTime(&scene, &image);
+
+	std::printf("%d line items, %dx%d image, average of %d renders\n",
+		numberOfRows * numberOfColumns, image.width(), image.height(), numberOfRenders);
+	std::printf("  Display lists disabled:           %8.1f ms\n", noDisplayListTime);
+	std::printf("  Display lists without batching:   %8.1f ms\n", displayListTime);
+	std::printf("  Display lists with batching:      %8.1f ms\n", batchedDisplayListTime);
+
+	return 0;
+}
@@ -23,9 +23,15 @@
 
 #include <DrawingView.h>
 #include <DrawingScene.h>
+#include <DrawingSceneDensity.h>
+#include <DrawingSceneIndex.h>
+#include <DrawingSceneOrder.h>
+#include <DrawingSceneSnapshot.h>
 #include <DrawingItem.h>
 #include <DrawingItemPoint.h>
 #include <DrawingItemStyle.h>
+#include <DrawingDisplayList.h>
+#include <DrawingTextLayout.h>
 
 #include <DrawingArcItem.h>
 #include <DrawingCurveItem.h>
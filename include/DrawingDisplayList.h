@@ -0,0 +1,228 @@
+/* DrawingDisplayList.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGDISPLAYLIST_H
+#define DRAWINGDISPLAYLIST_H
+
+#include <QtGui>
+
+class DrawingDisplayListEngine;
+class DrawingDisplayListBatch;
+
+/*! \brief Flat list of drawing operations recorded from a QPainter, which can be replayed onto
+ * another painter.
+ *
+ * DrawingDisplayList is a QPaintDevice.  Anything painted onto it using a QPainter is recorded as
+ * a list of primitive operations (paths, lines, polygons, rects, ellipses, text, and images), each
+ * with the resolved pen, brush, font, transform, and opacity that were set on the painter at the
+ * time.  Consecutive operations that use the same painter state share a single copy of it.  Other
+ * painter state, such as clipping and composition modes, is not recorded.
+ *
+ * DrawingItem uses a DrawingDisplayList to keep a recording of its render() function, which is
+ * only rebuilt when the item changes.  When DrawingScene::usesDisplayLists() is set, the scene
+ * replays these recordings instead of calling render() on each item.
+ *
+ * The list is recorded at a resolution of 96 dots per inch.  When it is replayed onto a device with
+ * a different resolution, the font sizes are adjusted in the same way that items adjust their font
+ * in render().
+ *
+ * Once recorded, a DrawingDisplayList may be replayed from several threads at once.  Copies of a
+ * list share its recorded operations, so copying a list is cheap, and recording into a list
+ * afterwards does not affect any of its copies.  This allows a copy to be replayed on another
+ * thread while the original is recorded again.
+ */
+class DrawingDisplayList : public QPaintDevice
+{
+	friend class DrawingDisplayListEngine;
+	friend class DrawingDisplayListBatch;
+
+private:
+	enum OperationType { PathOperation, LinesOperation, PolygonOperation, WindingPolygonOperation,
+		PolylineOperation, PointsOperation, RectOperation, EllipseOperation, TextOperation,
+		ImageOperation };
+
+	struct State
+	{
+		QPen pen;
+		QBrush brush;
+		QFont font;
+		QTransform transform;
+		qreal opacity;
+	};
+
+	struct Operation
+	{
+		OperationType type;
+		int stateIndex;
+		QPainterPath path;
+		QPolygonF points;
+		QRectF rect;
+		QRectF sourceRect;
+		QString text;
+		QImage image;
+	};
+
+	QVector<State> mStates;
+	QVector<Operation> mOperations;
+
+	mutable DrawingDisplayListEngine* mEngine;
+
+public:
+	//! \brief Create a new, empty DrawingDisplayList.
+	DrawingDisplayList();
+
+	/*! \brief Create a new DrawingDisplayList as a copy of an existing list.
+	 *
+	 * The new list shares the recorded operations of the existing list.
+	 */
+	DrawingDisplayList(const DrawingDisplayList& list);
+
+	//! \brief Delete an existing DrawingDisplayList object.
+	~DrawingDisplayList();
+
+
+	/*! \brief Sets the operations of this list to a copy of those of another list.
+	 *
+	 * This function must not be called while a QPainter is active on the list.
+	 */
+	DrawingDisplayList& operator=(const DrawingDisplayList& list);
+
+
+	/*! \brief Replays the recorded operations onto the specified painter.
+	 *
+	 * The operations are drawn relative to the painter's current transform.  The painter's pen,
+	 * brush, font, and opacity are restored afterwards.
+	 *
+	 * The level-of-detail thresholds are given in device pixels, in the same way as the
+	 * corresponding DrawingView settings.  Pens narrower than minimumPenWidth are drawn as cosmetic
+	 * pens, and text smaller than minimumTextSize is skipped.  Pass 0 to draw everything as
+	 * recorded.
+	 */
+	void draw(QPainter* painter, qreal minimumPenWidth = 0, qreal minimumTextSize = 0) const;
+
+	/*! \brief Removes all recorded operations.
+	 *
+	 * This function must not be called while a QPainter is active on the list.
+	 */
+	void clear();
+
+	/*! \brief Returns true if the list does not contain any operations.
+	 */
+	bool isEmpty() const;
+
+	/*! \brief Returns the number of operations in the list.
+	 */
+	int operationCount() const;
+
+
+	/*! \brief Returns the paint engine that records operations into the list.
+	 */
+	virtual QPaintEngine* paintEngine() const;
+
+protected:
+	virtual int metric(PaintDeviceMetric metric) const;
+};
+
+//==================================================================================================
+
+/*! \brief Combines the primitives of several DrawingDisplayList objects that share the same style
+ * so that they can be drawn with a single call.
+ *
+ * Most items in a typical diagram, such as lines, polylines, and rects without arrows or rounded
+ * corners, record a single primitive.  When many consecutive items use the same pen (and brush),
+ * drawing them one at a time spends most of its time changing the painter's state.  Instead,
+ * DrawingScene adds each item's display list to a DrawingDisplayListBatch and draws the whole
+ * batch with one QPainter::drawLines() or QPainter::drawRects() call once an item that does not
+ * match is reached.
+ *
+ * A display list can only be added if it contains exactly one operation and that operation is one
+ * of the following:
+ * \li Lines, or a path made up only of separate line segments (as drawn by DrawingLineItem and
+ *     DrawingPolylineItem), drawn with a solid, opaque pen.  Overlapping segments in a single
+ *     drawLines() call are not blended with each other, so translucent pens are not batched.
+ * \li A rect, where the transform of the rect does not rotate it.
+ *
+ * Items are added in z-order, and a batch only contains items that are drawn consecutively.
+ * QPainter::drawRects() fills every rect in the batch before stroking any of them, so a filled
+ * rect is not added if it overlaps (including its outline) a rect that is already in the batch;
+ * the batch must be drawn first.  With this restriction, the result is the same as drawing each
+ * item separately.
+ */
+class DrawingDisplayListBatch
+{
+private:
+	enum BatchType { NoBatch, LinesBatch, RectsBatch };
+
+	BatchType mType;
+	QPen mPen;
+	QBrush mBrush;
+
+	QVector<QPointF> mLinePoints;
+	QVector<QRectF> mRects;
+	QRectF mRectsBounds;
+
+public:
+	//! \brief Create a new, empty DrawingDisplayListBatch.
+	DrawingDisplayListBatch();
+
+	//! \brief Delete an existing DrawingDisplayListBatch object.
+	~DrawingDisplayListBatch();
+
+
+	/*! \brief Adds the primitive recorded in the display list to the batch.
+	 *
+	 * The primitive is mapped by transform into the coordinate system of the batch, which is the
+	 * coordinate system of the painter that the batch will be drawn with.
+	 *
+	 * Returns false, without changing the batch, if the display list cannot be batched, if it
+	 * uses a different primitive or style than the display lists already in the batch, or if it
+	 * is a filled rect that overlaps a rect in the batch.  In the latter cases, the batch should be
+	 * drawn before trying to add the display list again.
+	 */
+	bool add(const DrawingDisplayList& displayList, const QTransform& transform);
+
+	/*! \brief Draws all of the primitives in the batch and then clears the batch.
+	 *
+	 * Pens narrower than minimumPenWidth (in device pixels) are drawn as cosmetic pens, as in
+	 * DrawingDisplayList::draw().  The painter's pen and brush are restored afterwards.
+	 *
+	 * This function does nothing if the batch is empty.
+	 */
+	void draw(QPainter* painter, qreal minimumPenWidth = 0);
+
+	/*! \brief Removes all primitives from the batch without drawing them.
+	 */
+	void clear();
+
+	/*! \brief Returns true if the batch does not contain any primitives.
+	 */
+	bool isEmpty() const;
+
+private:
+	bool overlapsRects(const QRectF& rect) const;
+
+	static bool isOpaqueSolidPen(const QPen& pen);
+	static bool isLineSegmentPath(const QPainterPath& path);
+	static bool rectsTouch(const QRectF& rect1, const QRectF& rect2);
+
+	Q_DISABLE_COPY(DrawingDisplayListBatch)
+};
+
+#endif
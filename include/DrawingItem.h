@@ -22,8 +22,10 @@
 #define DRAWINGITEM_H
 
 #include <QtGui>
+#include <DrawingDisplayList.h>
 
 class DrawingScene;
+class DrawingView;
 class DrawingItemPoint;
 class DrawingItemStyle;
 
@@ -146,6 +148,9 @@ class DrawingItem
 {
 	friend class DrawingView;
 	friend class DrawingScene;
+	friend class DrawingItemPoint;
+	friend class DrawingItemStyle;
+	friend class DrawingItemGroup;
 
 public:
 	//! \brief Enum used to affect the behavior of the DrawingItem within the scene.
@@ -178,6 +183,13 @@ public:
 	};
 	Q_DECLARE_FLAGS(Flags, Flag)
 
+private:
+	struct DisplayListCache
+	{
+		DrawingDisplayList displayList;
+		QBrush backgroundBrush;
+	};
+
 private:
 	DrawingScene* mScene;
 
@@ -185,6 +197,25 @@ private:
 	QTransform mTransform;
 	QTransform mTransformInverse;
 
+	mutable QTransform mSceneTransform;
+	mutable QTransform mSceneTransformInverse;
+	mutable bool mSceneTransformValid;
+
+	mutable QRectF mBoundingRectCache;
+	mutable QPainterPath mShapeCache;
+	mutable QRectF mSceneBoundingRectCache;
+	mutable bool mBoundingRectCacheValid;
+	mutable bool mShapeCacheValid;
+	mutable bool mSceneBoundingRectCacheValid;
+	mutable quint64 mGeometryCacheStyleVersion;
+
+	mutable QPainterPath mHitShapeCache;
+	mutable int mHitShapeCacheBucket;
+	mutable bool mHitShapeCacheValid;
+
+	DisplayListCache* mDisplayListCache;
+	mutable bool mDisplayListValid;
+
 	Flags mFlags;
 	DrawingItemStyle* mStyle;
 
@@ -192,6 +223,8 @@ private:
 
 	QList<DrawingItem*> mChildren;
 	DrawingItem* mParent;
+	int mChildIndex;
+	DrawingItem* mGroup;
 
 	bool mVisible;
 	bool mSelected;
@@ -317,6 +350,24 @@ public:
 	 */
 	QTransform transformInverted() const;
 
+	/*! \brief Returns the transformation matrix that maps from the item's coordinate system to
+	 * the coordinate system of the scene.
+	 *
+	 * This combines the item's position() and transform() with those of each of its parents.
+	 * The result is cached and only recalculated after the position or transform of the item
+	 * or one of its parents changes, or after the item is added to or removed from a parent.
+	 *
+	 * \sa sceneTransformInverted(), mapToScene(), sceneBoundingRect()
+	 */
+	QTransform sceneTransform() const;
+
+	/*! \brief Returns the transformation matrix that maps from the coordinate system of the
+	 * scene to the item's coordinate system.
+	 *
+	 * \sa sceneTransform(), mapFromScene()
+	 */
+	QTransform sceneTransformInverted() const;
+
 
 	/*! \brief Sets the type of item through a combination of flags.
 	 *
@@ -348,6 +399,10 @@ public:
 	 * style from memory and replace it with the specified style.  DrawingItem takes ownership of
 	 * the new style and will delete it as necessary.
 	 *
+	 * Changing the values of the item's style, either by replacing it with this function or
+	 * through the DrawingItemStyle functions, re-indexes the item and repaints it the next time
+	 * its scene's views are updated.
+	 *
 	 * It is safe to pass a nullptr to this function; if a nullptr is received, this function
 	 * does nothing.
 	 *
@@ -694,6 +749,78 @@ public:
 	QPainterPath mapToScene(const QPainterPath& path) const;
 
 
+	/*! \brief Returns the item's boundingRect() in the coordinate system of the scene.
+	 *
+	 * This is equivalent to mapToScene(boundingRect()).boundingRect(), but the result is cached
+	 * until the item's geometry or sceneTransform() changes.
+	 *
+	 * \sa cachedBoundingRect(), sceneTransform()
+	 */
+	QRectF sceneBoundingRect() const;
+
+	/*! \brief Returns the result of boundingRect(), which is cached until the item's geometry
+	 * or style changes.
+	 *
+	 * The cache is cleared whenever prepareGeometryChange() is called, the item's points are
+	 * changed, or any value in the item's style() (or any default style value) changes.
+	 *
+	 * DrawingScene and DrawingView use this function instead of calling boundingRect() directly.
+	 *
+	 * \sa cachedShape(), prepareGeometryChange()
+	 */
+	QRectF cachedBoundingRect() const;
+
+	/*! \brief Returns the result of shape(), which is cached until the item's geometry or style
+	 * changes.
+	 *
+	 * The cache is cleared whenever prepareGeometryChange() is called, the item's points are
+	 * changed, or any value in the item's style() (or any default style value) changes.
+	 *
+	 * DrawingScene and DrawingView use this function instead of calling shape() directly.
+	 *
+	 * \sa cachedBoundingRect(), prepareGeometryChange()
+	 */
+	QPainterPath cachedShape() const;
+
+	/*! \brief Returns the shape used to hit test the item, with its outline widened to at least
+	 * minimumPenWidth.
+	 *
+	 * If the item's style has a pen width greater than zero but less than minimumPenWidth, the
+	 * returned path is the item's cachedShape() expanded so that its outline is approximately
+	 * minimumPenWidth wide.  This makes it easier to select thin items when the view is zoomed
+	 * out.  Otherwise, the item's cachedShape() is returned unchanged.
+	 *
+	 * The minimumPenWidth is given in local item coordinates.  It is rounded up to the nearest
+	 * half power of two, and the widened shape is cached for that value, so that it is only
+	 * rebuilt when the zoom level changes significantly or the item's geometry or style changes.
+	 *
+	 * Unlike temporarily changing the item's style, this function does not modify the item.
+	 *
+	 * \sa cachedShape()
+	 */
+	QPainterPath cachedHitShape(qreal minimumPenWidth) const;
+
+	/*! \brief Returns a recording of the item's render() function, which is kept until the
+	 * item's geometry or style changes.
+	 *
+	 * The recording is cleared under the same conditions as cachedBoundingRect(), and also when
+	 * the background brush of the item's scene changes, since items may use the painter's initial
+	 * brush to fill parts of their contents.  It is rebuilt the next time this function is
+	 * called.  Only the item itself is recorded, not its children.
+	 *
+	 * The item is recorded without any level-of-detail settings applied; instead, the
+	 * DrawingDisplayList applies the thresholds of the rendering view as it is replayed.
+	 *
+	 * DrawingScene uses this function instead of calling render() directly when
+	 * DrawingScene::usesDisplayLists() is set.  The recording is only allocated the first time
+	 * this function is called, and is released again if the scene stops using display lists, so
+	 * items in scenes that do not use display lists do not pay for it.
+	 *
+	 * \sa DrawingDisplayList::draw(), prepareGeometryChange()
+	 */
+	const DrawingDisplayList& displayList();
+
+
 	/*! \brief Returns an estimate of the area painted by an item.
 	 *
 	 * The function returns a rectangle in local item coordinates.
@@ -703,6 +830,10 @@ public:
 	 * items.  A better approach would be to determine a quick way to estimate this rect without
 	 * creating a QPainterPath.
 	 *
+	 * The result of this function is cached by cachedBoundingRect().  Derived classes whose
+	 * bounding rect depends on anything other than the item's points and style must call
+	 * prepareGeometryChange() whenever that changes.
+	 *
 	 * \sa shape(), centerPos(), isValid()
 	 */
 	virtual QRectF boundingRect() const = 0;
@@ -719,6 +850,10 @@ public:
 	 * drawing. To include this outline in the item's shape, create a shape from the stroke using
 	 * QPainterPathStroker.
 	 *
+	 * The result of this function is cached by cachedShape().  Derived classes whose shape
+	 * depends on anything other than the item's points and style must call
+	 * prepareGeometryChange() whenever that changes.
+	 *
 	 * \sa boundingRect(), centerPos(), isValid()
 	 */
 	virtual QPainterPath shape() const;
@@ -754,6 +889,10 @@ public:
 	 * This function is typically called by DrawingScene when rendering the scene.  DrawingScene
 	 * handles all of the necessary transformations, so this function should paint the item in
 	 * local item coordinates.
+	 *
+	 * DrawingScene does not call this function for items that are entirely outside of the area
+	 * being painted.  Items with complex contents may call exposedRect() to skip painting any
+	 * parts of the item that are not visible.
 	 */
 	virtual void render(QPainter* painter) = 0;
 
@@ -875,8 +1014,73 @@ protected:
 	virtual void keyReleaseEvent(QKeyEvent* event);
 
 protected:
+	/*! \brief Notifies the item that its geometry is changing.
+	 *
+	 * This function clears the cached boundingRect(), shape(), and displayList() of the item and
+	 * marks the item to be updated in its DrawingScene's spatial index.  Because the caches are
+	 * rebuilt lazily, it may be called either before or after the change is made.
+	 *
+	 * DrawingItem calls this function automatically when the item's points are added, removed, or
+	 * moved and when the item's style is replaced.  Derived classes must call it whenever the
+	 * result of boundingRect() or shape() or the output of render() changes for any other reason.
+	 *
+	 * \sa cachedBoundingRect(), cachedShape(), displayList()
+	 */
+	void prepareGeometryChange();
+
 	QPainterPath strokePath(const QPainterPath& path, const QPen& pen) const;
 
+	/*! \brief Returns the area of the item that is being painted, in local item coordinates.
+	 *
+	 * This function is intended to be called from within render() using the painter passed to
+	 * render().  The exposed rect is determined from the painter's clip region, which is set by
+	 * DrawingView to the area of the scene being painted.
+	 *
+	 * Returns a null rect if the painter has no clip region, in which case the entire item should
+	 * be painted.
+	 */
+	QRectF exposedRect(QPainter* painter) const;
+
+	/*! \brief Returns the number of device pixels per unit of local item coordinates.
+	 *
+	 * This function is intended to be called from within render() using the painter passed to
+	 * render().  It is used by the level-of-detail functions below.
+	 *
+	 * \sa isTextVisible(), isDetailVisible(), renderPen()
+	 */
+	qreal renderScale(QPainter* painter) const;
+
+	/*! \brief Returns true if text drawn with the specified font is large enough to be drawn.
+	 *
+	 * Text is not drawn if its size in device pixels is less than the DrawingView::minimumTextSize()
+	 * of the view that is rendering the scene.  If the item is not being rendered by a view, this
+	 * function always returns true.
+	 *
+	 * \sa isDetailVisible(), renderScale()
+	 */
+	bool isTextVisible(QPainter* painter, const QFont& font) const;
+
+	/*! \brief Returns true if a detail of the specified size (in local item coordinates), such as
+	 * an arrowhead, is large enough to be drawn.
+	 *
+	 * Details are not drawn if their size in device pixels is less than the
+	 * DrawingView::minimumDetailSize() of the view that is rendering the scene.  If the item is not
+	 * being rendered by a view, this function always returns true.
+	 *
+	 * \sa isTextVisible(), renderScale()
+	 */
+	bool isDetailVisible(QPainter* painter, qreal size) const;
+
+	/*! \brief Returns the pen that should be used to draw the item using the specified painter.
+	 *
+	 * If the pen would be narrower than the DrawingView::minimumRenderPenWidth() of the view that
+	 * is rendering the scene, a cosmetic pen with the same color and style is returned instead.
+	 * Otherwise the pen is returned unchanged.
+	 *
+	 * \sa renderScale()
+	 */
+	QPen renderPen(QPainter* painter, const QPen& pen) const;
+
 public:
 	/*! \brief Creates a copy of each of the specified items and returns them as a new list.
 	 *
@@ -887,6 +1091,18 @@ public:
 	 * list.  Any item point connections to items not in the original list are broken.
 	 */
 	static QList<DrawingItem*> copyItems(const QList<DrawingItem*>& items);
+
+private:
+	void invalidateSceneTransform();
+	void invalidateSceneTransformCache();
+	void updateSceneTransform() const;
+
+	void checkGeometryCacheStyle() const;
+	void markSceneIndexDirty();
+	void styleChanged();
+	void updateChildIndices(int firstIndex);
+	void releaseDisplayList();
+	const DrawingView* renderView(QPainter* painter) const;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(DrawingItem::Flags)
@@ -23,6 +23,8 @@
 
 #include <QtGui>
 
+class DrawingItem;
+
 /*! \brief Class for managing common item style properties.
  *
  * Each DrawingItem object is created with an empty DrawingItemStyle object, which can be
@@ -31,27 +33,55 @@
  * properties already.
  *
  * The list of supported item style properties is given by the DrawingItemStyle::Property enum.
- * Properties are stored as QVariant objects.  Each property is associated with a variant of a
- * specific data type.  DrawingItemStyle assumes that properties are set using the specific data
- * type; use of other data types will result in undefined behavior.
+ * Properties are set and returned as QVariant objects.  Each property is associated with a variant
+ * of a specific data type.  DrawingItemStyle assumes that properties are set using the specific
+ * data type; use of other data types will result in undefined behavior.
+ *
+ * To keep styles small, the values are not stored as QVariant objects.  Each style stores a bitmask
+ * of the properties that are set along with a compact array holding only the values of those
+ * properties, converted to their specific data type.  Colors are stored as 64-bit RGBA values,
+ * so a QColor set using a different color spec is returned as the equivalent RGB color.  Setting a
+ * property to an invalid QVariant is the same as calling unsetValue().
+ *
+ * Styles are implicitly shared.  The property values are stored in an immutable record that is
+ * interned, so all styles with identical values share a single record, along with the pen(),
+ * brush(), and other values resolved from it.  Copying a style (as DrawingItem's copy constructor
+ * does) is therefore cheap and does not use any additional memory for the values.  Modifying a
+ * style builds the new set of values and looks it up in the intern table, so only the modified
+ * style is affected and it again shares its record with any other style that has the same values.
  *
  * DrawingItemStyle also supports a set of default style properties.  If a property is not set on
  * a particular style, DrawingItemStyle will attempt to use the default property value.
  *
+ * Styles may also reference a named style class using setStyleClass().  A style class is a shared
+ * set of property values identified by name and managed through static functions such as
+ * setClassValue().  Editing a style class restyles every style that references it: each style's
+ * version() includes the version of its class, so cached values are simply recomputed the next
+ * time they are used, without visiting each style.  The next time its views are updated, a
+ * DrawingScene re-indexes and repaints only the items that reference an edited style class.  A
+ * change to the default values may affect any item, so it updates all of the scene's items.
+ *
  * DrawingItem classes should use the valueLookup() functions to determine the property value using
- * default style properties.  If the style has a value() for the specified property, that value is
- * returned.  If not, then if the DrawingItemStyle has a defaultValue() for the specified property,
- * then that default value is returned.  It is recommended that each supported #Property have a
- * default value stored using setDefaultValue().  If neither a local value or default value is found
- * for the specified property, the behavior is not well defined.
+ * the style class and default style properties.  If the style has a value() for the specified
+ * property, that value is returned.  If not, then if the style's class has a classValue() for the
+ * specified property, that value is returned.  If not, then if the DrawingItemStyle has a
+ * defaultValue() for the specified property, then that default value is returned.  It is
+ * recommended that each supported #Property have a default value stored using setDefaultValue().
+ * If neither a local value or default value is found for the specified property, the behavior is
+ * not well defined.
  *
  * DrawingItemStyle provides several convenience functions to look up common properties: pen(),
  * brush(), font(), textBrush(), textAlignment(), startArrowStyle(), startArrowSize(),
- * endArrowStyle(), and endArrowSize().  These functions use valueLookup() to find each related
- * property for that function.
+ * endArrowStyle(), and endArrowSize().  These values are resolved using valueLookup() and stored
+ * with the shared record whenever a new record is interned, and again for every affected record
+ * when the default values or a style class change.  The functions simply return the stored
+ * values, so they are cheap enough to call from DrawingItem::render() and DrawingItem::shape(),
+ * and they never modify the style, so items may be rendered from several threads at once.
  */
 class DrawingItemStyle
 {
+	friend class DrawingItem;
+
 public:
 	//! \brief Enum represents the supported item style properties.
 	enum Property
@@ -103,7 +133,71 @@ public:
 	};
 
 private:
-	QHash<Property,QVariant> mProperties;
+	struct ResolvedValues
+	{
+		QPen pen;
+		QBrush brush;
+		QFont font;
+		QBrush textBrush;
+		Qt::Alignment textAlignment;
+		ArrowStyle startArrowStyle;
+		qreal startArrowSize;
+		ArrowStyle endArrowStyle;
+		qreal endArrowSize;
+	};
+
+	enum PropertyType { UIntType, RealType, BoolType, ColorType, StringType };
+
+	union PropertyValue
+	{
+		uint uintValue;
+		qreal realValue;
+		bool boolValue;
+		quint64 colorValue;
+	};
+
+	class StyleClass;
+
+	class Data : public QSharedData
+	{
+	public:
+		quint32 propertyMask;
+		QVector<PropertyValue> propertyValues;
+		QString fontName;
+		StyleClass* styleClass;
+
+		quint64 version;
+		uint hash;
+		bool interned;
+
+		ResolvedValues resolved;
+
+		Data();
+		Data(const Data& data);
+		~Data();
+
+		void setValue(Property index, const QVariant& value);
+		void unsetValue(Property index);
+		void clearValues();
+		bool hasValue(Property index) const;
+		QVariant value(Property index) const;
+
+		int propertySlot(Property index) const;
+		uint valueHash() const;
+		bool hasSameValues(const Data& data) const;
+	};
+
+	class StyleClass
+	{
+	public:
+		QString name;
+		Data values;
+		quint64 version;
+	};
+
+	QExplicitlySharedDataPointer<Data> mData;
+	quint64 mVersion;
+	DrawingItem* mItem;
 
 public:
 	/*! \brief Create a new DrawingItemStyle.
@@ -114,7 +208,8 @@ public:
 
 	/*! \brief Create a new DrawingItemStyle based on the specified style.
 	 *
-	 * The new style has the same properties as the existing style.
+	 * The new style has the same properties as the existing style.  It is not associated with the
+	 * existing style's item.
 	 */
 	DrawingItemStyle(const DrawingItemStyle& style);
 
@@ -124,6 +219,12 @@ public:
 	 */
 	~DrawingItemStyle();
 
+	/*! \brief Sets this style's properties to those of the specified style.
+	 *
+	 * The two styles share the same values until one of them is modified.
+	 */
+	DrawingItemStyle& operator=(const DrawingItemStyle& style);
+
 
 	/*! \brief Set the style's properties and values.
 	 *
@@ -173,22 +274,44 @@ public:
 	QVariant value(Property index) const;
 
 
-	/*! \brief Return the value for a specific property based on the style's value or a default value.
+	/*! \brief Sets the name of the style class referenced by this style.
 	 *
-	 * If the style has a value for the property, that value is returned.  If not, and the
+	 * The style class is created if it does not already exist.  Passing an empty name removes the
+	 * style's reference to any style class.
+	 *
+	 * \sa styleClass(), setClassValue()
+	 */
+	void setStyleClass(const QString& className);
+
+	/*! \brief Returns the name of the style class referenced by this style.
+	 *
+	 * If the style does not reference a style class, an empty string is returned.
+	 *
+	 * \sa setStyleClass()
+	 */
+	QString styleClass() const;
+
+
+	/*! \brief Return the value for a specific property based on the style's value, its style class,
+	 * or a default value.
+	 *
+	 * If the style has a value for the property, that value is returned.  If not, and the style's
+	 * class has a value for the property, that value is returned.  If not, and the
 	 * DrawingItemStyle has a default value for the property, that value is returned.  If no
-	 * value is found in either the style's local properties or the class's default properties,
+	 * value is found in the style's local properties, the style class, or the default properties,
 	 * an empty QVariant object is returned.
 	 *
 	 * \sa value(), valueLookup(Property, const QVariant&)
 	 */
 	QVariant valueLookup(Property index) const;
 
-	/*! \brief Return the value for a specific property based on the style's value or a default value.
+	/*! \brief Return the value for a specific property based on the style's value, its style class,
+	 * or a default value.
 	 *
-	 * If the style has a value for the property, that value is returned.  If not, and the
+	 * If the style has a value for the property, that value is returned.  If not, and the style's
+	 * class has a value for the property, that value is returned.  If not, and the
 	 * DrawingItemStyle has a default value for the property, that value is returned.  If no
-	 * value is found in either the style's local properties or the class's default properties,
+	 * value is found in the style's local properties, the style class, or the default properties,
 	 * the specified fallback value is returned.
 	 *
 	 * \sa value(), valueLookup(Property, const QVariant&)
@@ -196,11 +319,21 @@ public:
 	QVariant valueLookup(Property index, const QVariant& fallbackValue) const;
 
 
+	/*! \brief Returns a number that changes whenever any of the style's values, the values of its
+	 * style class, or any of the default values change.
+	 *
+	 * Items use this to determine whether values they have cached based on the style, such as
+	 * their boundingRect() or shape(), are still valid.  Each style has its own version, so a style
+	 * that is changed to values it shares with an older style still gets a new version.
+	 */
+	quint64 version() const;
+
+
 	/*! \brief Convenience function that creates a QPen object based upon the style's pen properties.
 	 *
 	 * This function uses valueLookup() to get the values of the #PenStyle, #PenColor, #PenOpacity,
 	 * #PenWidth, #PenCapStyle, and #PenJoinStyle.  These values are combined in a QPen object
-	 * and returned.
+	 * and returned.  The QPen is cached until the style's version() changes.
 	 */
 	QPen pen() const;
 
@@ -283,18 +416,40 @@ public:
 	 *
 	 * The arrow's path is drawn from the given position in the specified direction.
 	 *
+	 * The geometry of recently used arrows is cached by style, size, and direction, so drawing or
+	 * computing the shape of the same arrow again only needs to translate the cached geometry
+	 * to the given position.
+	 *
 	 * \sa arrowShape()
 	 */
 	QPainterPath arrowShape(ArrowStyle style, qreal size,
 		const QPointF& pos, qreal direction) const;
 
 private:
+	const ResolvedValues& resolvedValues() const;
+	quint64 dataVersion() const;
+
+	void setData(const Data& data);
+
+	static QVariant lookupValue(const Data* data, Property index, const QVariant& fallbackValue);
+	static void resolveValues(Data* data);
+	static void resolveInternedData(const StyleClass* styleClass);
+
+	static PropertyType propertyType(Property index);
+
 	QPolygonF calculateArrowPoints(ArrowStyle style, qreal size,
 		const QPointF& pos, qreal direction) const;
 
 
 private:
 	static QHash<Property,QVariant> mDefaultProperties;
+	static quint64 mDefaultVersion;
+	static quint64 mVersionCounter;
+
+	static QMultiHash<uint,Data*> mInternedData;
+
+	static QHash<QString,StyleClass*> mStyleClasses;
+	static quint64 mClassVersion;
 
 public:
 	/*! \brief Set the default properties and values for all DrawingItemStyle objects.
@@ -346,6 +501,96 @@ public:
 	 * \sa setValue(), valueLookup()
 	 */
 	static QVariant defaultValue(Property index);
+
+
+	/*! \brief Set the properties and values of the specified style class.
+	 *
+	 * The style class is created if it does not already exist.  Existing properties and values
+	 * are cleared to make way for the new values.
+	 *
+	 * \sa setClassValue(), classValues()
+	 */
+	static void setClassValues(const QString& className, const QHash<Property,QVariant>& values);
+
+	/*! \brief Return all of the properties and values of the specified style class.
+	 *
+	 * \sa setClassValues(), classValue()
+	 */
+	static QHash<Property,QVariant> classValues(const QString& className);
+
+
+	/*! \brief Set the value of the specified property of a style class to value.
+	 *
+	 * The style class is created if it does not already exist.
+	 *
+	 * \sa setClassValues(), unsetClassValue(), classValue()
+	 */
+	static void setClassValue(const QString& className, Property index, const QVariant& value);
+
+	/*! \brief Unset the value of the specified property of a style class.
+	 *
+	 * \sa setClassValue(), clearClassValues()
+	 */
+	static void unsetClassValue(const QString& className, Property index);
+
+	/*! \brief Clear all property values from the specified style class.
+	 *
+	 * Styles that reference the class keep doing so, but use their own values and the default
+	 * values until new values are set on the class.
+	 *
+	 * \sa unsetClassValue()
+	 */
+	static void clearClassValues(const QString& className);
+
+	/*! \brief Returns true if the specified style class has a value set for the specific
+	 * property, false otherwise.
+	 *
+	 * \sa classValue()
+	 */
+	static bool hasClassValue(const QString& className, Property index);
+
+	/*! \brief Return the value for a specific property of the specified style class.
+	 *
+	 * If the style class does not have a value for the property, an empty QVariant object is
+	 * returned.
+	 *
+	 * \sa setClassValue(), valueLookup()
+	 */
+	static QVariant classValue(const QString& className, Property index);
+
+	/*! \brief Returns the names of all style classes.
+	 *
+	 * \sa setStyleClass()
+	 */
+	static QStringList classNames();
+
+
+	/*! \brief Returns a number that changes whenever any of the default values or any of the
+	 * style class values change.
+	 *
+	 * DrawingScene uses this to determine when any of its items may need to be updated.
+	 *
+	 * \sa defaultVersion(), classVersion(), version()
+	 */
+	static quint64 sharedVersion();
+
+	/*! \brief Returns a number that changes whenever any of the default values change.
+	 *
+	 * \sa sharedVersion()
+	 */
+	static quint64 defaultVersion();
+
+	/*! \brief Returns a number that changes whenever the values of the specified style class
+	 * change.
+	 *
+	 * If the style class does not exist, 0 is returned.
+	 *
+	 * \sa sharedVersion()
+	 */
+	static quint64 classVersion(const QString& className);
+
+private:
+	static StyleClass* findStyleClass(const QString& className, bool create);
 };
 
 #endif
@@ -22,10 +22,14 @@
 #define DRAWINGSCENE_H
 
 #include <QtGui>
+#include <DrawingSceneIndex.h>
+#include <DrawingSceneDensity.h>
+#include <DrawingSceneOrder.h>
 
 class DrawingView;
 class DrawingItem;
 class DrawingItemPoint;
+class DrawingSceneSnapshot;
 
 /*! \brief Surface for managing a large number of two-dimensional DrawingItem objects.
  *
@@ -49,20 +53,52 @@ class DrawingItemPoint;
  * \li The visibleItemAt(const DrawingView*, const QPointF&) const function is used to determine which
  * item (if any) was clicked on by the user.
  *
- * The contents of the scene are painted using the render() function.
+ * To keep these searches fast for scenes with a large number of items, DrawingScene maintains a
+ * spatial index (DrawingSceneIndex) of the scene bounding rect of every item and child item in the
+ * scene.  Items notify the scene whenever their position, transform, or geometry changes (see
+ * DrawingItem::prepareGeometryChange()), and the index is brought up to date before the next
+ * search or render.  Changes to an item's style are not tracked; call updateItemIndex() after
+ * changing the style of an item that is already in the scene.
+ *
+ * The order of the top-level items is stored in a DrawingSceneOrder, so that items can be inserted,
+ * removed, reordered, and located within items() in O(log n) time.
+ *
+ * The contents of the scene are painted using the render() function.  The areas of the scene
+ * that need to be repainted because items were added, removed, moved, reordered, shown, or hidden
+ * are reported through the changed() signal, which allows a DrawingView to cache its rendering of
+ * the scene.
  */
 class DrawingScene : public QObject
 {
 	Q_OBJECT
 
 	friend class DrawingView;
+	friend class DrawingItem;
 
 private:
 	QRectF mSceneRect;
 
 	QBrush mBackgroundBrush;
+	bool mUsesDisplayLists;
+	bool mBatchesDisplayLists;
+
+	DrawingSceneOrder mItemOrder;
+	mutable QList<DrawingItem*> mItems;
+	mutable bool mItemsValid;
+
+	mutable DrawingSceneIndex mItemIndex;
+	mutable DrawingSceneDensity mItemDensity;
+	mutable QSet<DrawingItem*> mDirtyIndexItems;
 
-	QList<DrawingItem*> mItems;
+	mutable QList<QRectF> mChangedRects;
+	mutable bool mEntireSceneChanged;
+	quint64 mSharedStyleVersion;
+	quint64 mDefaultStyleVersion;
+	QHash<QString,quint64> mStyleClassVersions;
+	mutable QHash<QString,QSet<DrawingItem*>> mStyleClassItems;
+	mutable QHash<DrawingItem*,QString> mItemStyleClasses;
+
+	const DrawingView* mRenderView;
 
 public:
 	/*! \brief Create a new DrawingScene with default settings.
@@ -117,6 +153,56 @@ public:
 	 */
 	QBrush backgroundBrush() const;
 
+	/*! \brief Sets whether the scene paints items by replaying their display lists.
+	 *
+	 * If enabled, each item's drawing is recorded into a DrawingDisplayList the first time it is
+	 * painted, and the recording is replayed instead of calling DrawingItem::render() until the
+	 * item changes.  This avoids recomputing the item's pens, paths, and text layout on every
+	 * paint, at the cost of the memory needed to keep each item's recording.  Consecutive items
+	 * that record a single line or rect primitive with the same style are also combined into one
+	 * QPainter call (see DrawingDisplayListBatch and setBatchesDisplayLists()), which reduces the
+	 * cost of painting diagrams made up of many similar wires.  The program in the benchmark
+	 * directory measures the difference for 100000 line items.  Because the recordings are
+	 * replayed by render(), they are shared by DrawingView and by any export or offscreen
+	 * rendering of the scene.
+	 *
+	 * Any state that an item's render() reads must invalidate the item's display list when it
+	 * changes, or the old recording keeps being replayed.  DrawingItem does this for its geometry,
+	 * style, and selection state.  Items whose render() output depends on anything else must call
+	 * DrawingItem::prepareGeometryChange() when it changes.
+	 *
+	 * A DrawingView with the DrawingView::AsynchronousRendering flag set uses the display lists
+	 * of the visible items even if this setting is disabled.
+	 *
+	 * Display lists are disabled by default.
+	 *
+	 * \sa usesDisplayLists(), setBatchesDisplayLists(), DrawingItem::displayList()
+	 */
+	void setUsesDisplayLists(bool enabled);
+
+	/*! \brief Returns true if the scene paints items by replaying their display lists.
+	 *
+	 * \sa setUsesDisplayLists()
+	 */
+	bool usesDisplayLists() const;
+
+	/*! \brief Sets whether consecutive display lists are combined into batches when painted.
+	 *
+	 * This setting only has an effect if usesDisplayLists() is set.  If disabled, each item's
+	 * display list is replayed separately.
+	 *
+	 * Batching is enabled by default.
+	 *
+	 * \sa batchesDisplayLists(), setUsesDisplayLists()
+	 */
+	void setBatchesDisplayLists(bool enabled);
+
+	/*! \brief Returns true if consecutive display lists are combined into batches when painted.
+	 *
+	 * \sa setBatchesDisplayLists()
+	 */
+	bool batchesDisplayLists() const;
+
 
 	/*! \brief Adds an existing item to the scene.
 	 *
@@ -180,6 +266,30 @@ public:
 	 */
 	QList<DrawingItem*> items() const;
 
+	/*! \brief Returns the index of each of the specified items within items().
+	 *
+	 * Each item is located in O(log n) time, so this function is much faster than calling
+	 * items().indexOf() for each item when working with a large number of items.
+	 *
+	 * Items that are not top-level items in the scene are not included in the result.
+	 *
+	 * \sa items(), insertItems()
+	 */
+	QHash<DrawingItem*,int> itemIndices(const QList<DrawingItem*>& items) const;
+
+
+	/*! \brief Updates the scene's spatial index for the specified item and its children.
+	 *
+	 * Changes to an item's position, transform, points, and geometry are tracked by the scene
+	 * automatically.  This function only needs to be called after changing a value in the
+	 * DrawingItemStyle of an item that is already in the scene, since style changes may affect
+	 * the item's boundingRect() without notifying the scene.
+	 *
+	 * It is safe to pass a nullptr to this function; if a nullptr is received, this function
+	 * does nothing.  This function also does nothing if the item is not in the scene.
+	 */
+	void updateItemIndex(DrawingItem* item);
+
 
 	/*! \brief Returns a list of all currently visible items in the scene.
 	 *
@@ -194,7 +304,8 @@ public:
 	 * position.
 	 *
 	 * This function uses DrawingItem::shape() to determine the exact shape of each item to test
-	 * against the specified position.
+	 * against the specified position.  Only the items found near the specified position using the
+	 * scene's spatial index are tested.
 	 *
 	 * This function searches recursively through all top-level items in the scene.  Therefore it
 	 * may include items and their children that match the specified pos.
@@ -264,7 +375,11 @@ public:
 	 *
 	 * The default implementation is to first paint the sceneRect() using the scene's
 	 * backgroundBrush().  Then, all visible items are painted by calling DrawingItem::render() on
-	 * each visible item in the scene.
+	 * each visible item in the scene, or by replaying the item's DrawingItem::displayList() if
+	 * usesDisplayLists() is set.
+	 *
+	 * If the painter has a clip region set, only the items whose scene bounding rect intersects
+	 * with the clip region are painted.
 	 */
 	virtual void render(QPainter* painter);
 
@@ -280,8 +395,9 @@ public slots:
 
 	/*! \brief Inserts the specified items in the scene at the specified indices.
 	 *
-	 * This function calls insertItem() for each of the specified items.  It emits the
-	 * numberOfItemsChanged() signal when complete.
+	 * The result is the same as calling insertItem() for each of the specified items in order of
+	 * increasing index.  Items without an entry in indices are added to the end of the scene.  It
+	 * emits the numberOfItemsChanged() signal when complete.
 	 *
 	 * \sa addItems(), removeItems()
 	 */
@@ -289,13 +405,26 @@ public slots:
 
 	/*! \brief Removes the specified items from the scene.
 	 *
-	 * This function calls removeItem() for each of the specified items.  It emits the
-	 * numberOfItemsChanged() signal when complete.
+	 * The result is the same as calling removeItem() for each of the specified items.  It emits
+	 * the numberOfItemsChanged() signal when complete.
 	 *
 	 * \sa addItems(), insertItems()
 	 */
 	virtual void removeItems(const QList<DrawingItem*>& items);
 
+	/*! \brief Moves the specified top-level items to the specified indices within items().
+	 *
+	 * The items are first removed from the scene's item order and then re-inserted in order of
+	 * increasing index, so each index refers to the item's position in the final list.  The
+	 * relative order of all other items is unchanged.  Items that are not top-level items in the
+	 * scene or that do not have an entry in indices are ignored.
+	 *
+	 * Moving k items costs O(k log n), regardless of the number of items n in the scene.
+	 *
+	 * \sa itemIndices()
+	 */
+	virtual void reorderItems(const QList<DrawingItem*>& items, const QHash<DrawingItem*,int>& indices);
+
 
 	/*! \brief Shows or hides each of the specified items within the scene.
 	 *
@@ -443,6 +572,22 @@ signals:
 	 */
 	void itemsVisibilityChanged(const QList<DrawingItem*>& items);
 
+	/*! \brief Emitted when areas of the scene need to be repainted.
+	 *
+	 * The sceneRects are the old and new scene bounding rects of all items that were added,
+	 * removed, reordered, shown, hidden, or whose geometry changed since the last time this
+	 * signal was emitted.  If sceneRects is empty, the entire scene should be repainted; this is
+	 * the case after a change to the default style values.  After a change to a style class, only
+	 * the rects of the items that use the class are included.
+	 *
+	 * Unlike the other signals, this signal is emitted for changes made directly through the
+	 * functions in DrawingItem as well, including changes to the values of an item's style().
+	 * Changes are collected and reported just before a DrawingView paints the scene.  DrawingView
+	 * uses the other signals to update its cached tiles as soon as items are changed through the
+	 * scene, and this signal for everything else.
+	 */
+	void changed(const QList<QRectF>& sceneRects);
+
 
 protected:
 	/*! \brief Renders the background of the scene using the specified painter.
@@ -462,6 +607,9 @@ protected:
 	 * The default implementation renders items the order they were added to the scene, starting
 	 * with the first item added and ending with the most recent item added.
 	 *
+	 * If the painter has a clip region set, items (including child items) that lie entirely
+	 * outside of the clip region are skipped.
+	 *
 	 * This function may be overridden in a derived class to provide a custom rendering
 	 * implementation for items in the scene.
 	 *
@@ -469,6 +617,26 @@ protected:
 	 */
 	virtual void drawItems(QPainter* painter);
 
+	/*! \brief Renders an overview of the widget's items into the scene using the specified
+	 * painter.
+	 *
+	 * DrawingView calls this function instead of drawItems() when the scene is drawn at a scale
+	 * below its DrawingView::overviewScale().  At such scales, many items map to each pixel, so
+	 * drawing them individually is wasteful.
+	 *
+	 * The default implementation draws the density of the small top-level items in the scene,
+	 * using a summary that is kept up to date as items are added, moved, and removed.  An item is
+	 * small if it fits within a cell of the summary grid that is chosen for the painter's scale,
+	 * which is about one device pixel.  Larger items are found using the scene's spatial index and
+	 * rendered normally, in order, along with their children.  If the painter has a clip region
+	 * set, only the area within the clip region is drawn.
+	 *
+	 * This function may be overridden in a derived class to provide a custom overview.
+	 *
+	 * \sa drawItems()
+	 */
+	virtual void drawOverview(QPainter* painter);
+
 	/*! \brief Renders the foreground of the scene using the specified painter.
 	 *
 	 * The default implementation of this function does nothing.
@@ -482,7 +650,22 @@ protected:
 
 private:
 	void findItems(const QList<DrawingItem*>& items, QList<DrawingItem*>& foundItems) const;
+	QList<DrawingItem*> indexedItems(const QRectF& sceneRect) const;
+	qreal indexTolerance(const DrawingView* view) const;
+	void updateDirtyIndexItems() const;
+	void indexItem(DrawingItem* item) const;
+	void unindexItem(DrawingItem* item);
+	void addChangedRect(const QRectF& sceneRect) const;
+	void addChangedScene() const;
+	void processChanges();
+	void prepareConcurrentRender(const QRectF& sceneRect) const;
 	void drawItems(QPainter* painter, const QList<DrawingItem*>& items);
+	void drawItems(QPainter* painter, const QList<DrawingItem*>& items, const QRectF& exposedRect);
+	void snapshotItems(DrawingSceneSnapshot* snapshot, const QRectF& exposedRect);
+	bool itemIsExposed(DrawingItem* item, const QRectF& exposedRect) const;
+	void drawItemPlaceholder(QPainter* painter, DrawingItem* item, qreal deviceScale);
+	QRectF itemPlaceholderRect(DrawingItem* item, qreal deviceScale) const;
+	QColor itemPlaceholderColor(DrawingItem* item) const;
 
 	bool itemMatchesPoint(const DrawingView* view, DrawingItem* item, const QPointF& scenePos) const;
 	bool itemMatchesRect(const DrawingView* view, DrawingItem* item, const QRectF& rect, Qt::ItemSelectionMode mode) const;
@@ -0,0 +1,133 @@
+/* DrawingSceneDensity.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGSCENEDENSITY_H
+#define DRAWINGSCENEDENSITY_H
+
+#include <QtGui>
+
+class DrawingItem;
+
+/*! \brief Summary of the number of items in each area of the scene, used by DrawingScene to draw
+ * an overview of the scene at very small scales.
+ *
+ * DrawingSceneDensity divides the scene into a series of uniform grids of square cells.  The
+ * finest grid has cells with a size of cellSize(), and each of the coarser grids has cells
+ * levelFactor() times as large as the one before.  Each item is counted in the cell containing
+ * the center of its scene bounding rect, in the finest grid whose cells are at least as large as
+ * the item, and in every coarser grid.  The count of each cell is therefore the number of items
+ * that are no larger than the cell, so that the density of a large area of the scene can be found
+ * without visiting a large number of cells.
+ *
+ * Items that are larger than the cells of the coarsest grid are not counted at all.  When drawing
+ * an overview, DrawingScene draws the items that are larger than the cells of the grid it uses
+ * (see levelCellSize()) individually, since they are still visible at that scale.
+ *
+ * The counts are updated incrementally as items are added, moved, and removed.  Each update
+ * touches at most one cell in each grid.
+ *
+ * DrawingSceneDensity does not take ownership of any items.
+ */
+class DrawingSceneDensity
+{
+private:
+	struct ItemCell
+	{
+		int level;
+		int column;
+		int row;
+	};
+
+	qreal mCellSize;
+
+	QVector<QHash<quint64,int>> mLevels;
+	QHash<DrawingItem*,ItemCell> mItemCells;
+
+public:
+	/*! \brief Create a new, empty DrawingSceneDensity using cells of the specified size.
+	 *
+	 * The cellSize is given in scene coordinates.
+	 */
+	DrawingSceneDensity(qreal cellSize = 32);
+
+	//! \brief Delete an existing DrawingSceneDensity object.
+	~DrawingSceneDensity();
+
+
+	/*! \brief Returns the size of each cell in the finest grid, in scene coordinates.
+	 */
+	qreal cellSize() const;
+
+	/*! \brief Returns the ratio between the cell sizes of each grid and the next finer grid.
+	 */
+	static int levelFactor();
+
+	/*! \brief Returns the cell size of the grid that densityImage() uses for the specified
+	 * minimumCellSize.
+	 *
+	 * This is the cell size of the finest grid whose cells are at least minimumCellSize, or of the
+	 * coarsest grid if there is none.  Items that are wider or taller than this size are not
+	 * included in the density image.
+	 */
+	qreal levelCellSize(qreal minimumCellSize) const;
+
+
+	/*! \brief Adds or moves an item using the specified scene bounding rect.
+	 *
+	 * \sa removeItem()
+	 */
+	void updateItem(DrawingItem* item, const QRectF& sceneRect);
+
+	/*! \brief Removes an item from the summary.
+	 *
+	 * This function does nothing if the item is not in the summary.
+	 *
+	 * \sa updateItem(), clear()
+	 */
+	void removeItem(DrawingItem* item);
+
+	/*! \brief Removes all items from the summary.
+	 */
+	void clear();
+
+
+	/*! \brief Returns an image of the density of the items within the specified rect.
+	 *
+	 * The finest grid whose cells are at least minimumCellSize (in scene coordinates) is used, and
+	 * each pixel of the returned image represents one of its cells.  Only the items that are no
+	 * larger than these cells are included.  Pass the size of a device
+	 * pixel in scene coordinates so that the image is no larger than the area being painted.  The
+	 * pixels are filled with the specified color, with an alpha value based on the number of items
+	 * in the cell relative to its size.
+	 *
+	 * The area of the scene covered by the image, which is sceneRect expanded to whole cells, is
+	 * returned in imageRect.
+	 */
+	QImage densityImage(const QRectF& sceneRect, qreal minimumCellSize, const QColor& color,
+		QRectF& imageRect) const;
+
+private:
+	int level(qreal minimumCellSize) const;
+	void addToLevels(const ItemCell& cell, int count);
+
+	static quint64 cellKey(int column, int row);
+};
+
+#endif
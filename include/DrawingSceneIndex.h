@@ -0,0 +1,147 @@
+/* DrawingSceneIndex.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGSCENEINDEX_H
+#define DRAWINGSCENEINDEX_H
+
+#include <QtCore>
+
+class DrawingItem;
+
+/*! \brief Spatial index used by DrawingScene to quickly find the items near a given location.
+ *
+ * DrawingSceneIndex divides the scene into a uniform grid of square cells with a size of
+ * cellSize().  Each item is stored in every cell that its scene bounding rect overlaps.  Items
+ * whose bounding rect would cover a very large number of cells are instead stored in a separate
+ * list that is checked by every query.
+ *
+ * The items() functions return candidate items only: every item whose indexed rect intersects
+ * the query is returned, in no particular order.  It is up to the caller to perform any exact
+ * shape tests and to sort the results as needed.
+ *
+ * DrawingSceneIndex does not take ownership of any items.  DrawingScene is responsible for
+ * keeping the index up to date whenever an item's geometry changes.
+ */
+class DrawingSceneIndex
+{
+private:
+	qreal mCellSize;
+
+	QHash<quint64,QList<DrawingItem*>> mCells;
+	QList<DrawingItem*> mLargeItems;
+	QHash<DrawingItem*,QRectF> mItemRects;
+
+public:
+	/*! \brief Create a new, empty DrawingSceneIndex using cells of the specified size.
+	 *
+	 * The cellSize is given in scene coordinates.
+	 */
+	DrawingSceneIndex(qreal cellSize = 256);
+
+	//! \brief Delete an existing DrawingSceneIndex object.
+	~DrawingSceneIndex();
+
+
+	/*! \brief Returns the size of each cell in the index, in scene coordinates.
+	 *
+	 * The cell size is set when the index is created.
+	 */
+	qreal cellSize() const;
+
+
+	/*! \brief Adds an item to the index using the specified scene bounding rect.
+	 *
+	 * If the item is already in the index, this function is equivalent to calling updateItem().
+	 *
+	 * \sa removeItem(), updateItem()
+	 */
+	void insertItem(DrawingItem* item, const QRectF& sceneRect);
+
+	/*! \brief Removes an item from the index.
+	 *
+	 * This function does nothing if the item is not in the index.
+	 *
+	 * \sa insertItem(), clear()
+	 */
+	void removeItem(DrawingItem* item);
+
+	/*! \brief Updates the scene bounding rect of an item in the index.
+	 *
+	 * Only the cells affected by the change are updated.  If the item is not already in the
+	 * index, it is added.
+	 *
+	 * \sa insertItem()
+	 */
+	void updateItem(DrawingItem* item, const QRectF& sceneRect);
+
+	/*! \brief Removes all items from the index.
+	 *
+	 * \sa removeItem()
+	 */
+	void clear();
+
+
+	/*! \brief Returns true if the item is in the index, false otherwise.
+	 *
+	 * \sa itemRect()
+	 */
+	bool contains(DrawingItem* item) const;
+
+	/*! \brief Returns the scene bounding rect that the item was indexed with.
+	 *
+	 * Returns a null rect if the item is not in the index.
+	 *
+	 * \sa contains()
+	 */
+	QRectF itemRect(DrawingItem* item) const;
+
+	/*! \brief Returns the number of items in the index.
+	 */
+	int size() const;
+
+
+	/*! \brief Returns all indexed items whose scene bounding rect intersects with the specified
+	 * rect.
+	 *
+	 * Rects with a zero width or height are allowed; the comparison includes the edges of the
+	 * rect.
+	 *
+	 * If minimumSize is greater than 0, only items whose scene bounding rect is wider or taller
+	 * than minimumSize are returned.
+	 */
+	QList<DrawingItem*> items(const QRectF& sceneRect, qreal minimumSize = 0) const;
+
+	/*! \brief Returns all indexed items whose scene bounding rect contains the specified position.
+	 */
+	QList<DrawingItem*> items(const QPointF& scenePos) const;
+
+private:
+	bool cellRange(const QRectF& rect, int& left, int& top, int& right, int& bottom) const;
+	bool isLargeRange(int left, int top, int right, int bottom) const;
+
+	void addToCells(DrawingItem* item, const QRectF& rect);
+	void removeFromCells(DrawingItem* item, const QRectF& rect);
+
+	static quint64 cellKey(int column, int row);
+	static bool rectsIntersect(const QRectF& rect1, const QRectF& rect2);
+	static bool isLargerThan(const QRectF& rect, qreal minimumSize);
+};
+
+#endif
@@ -0,0 +1,133 @@
+/* DrawingSceneOrder.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGSCENEORDER_H
+#define DRAWINGSCENEORDER_H
+
+#include <QtCore>
+
+class DrawingItem;
+
+/*! \brief Ordered list of items used by DrawingScene to store the z-order of its top-level items.
+ *
+ * DrawingSceneOrder behaves like a QList<DrawingItem*> that does not contain duplicates, but is
+ * implemented as a balanced binary tree in which each node also stores the size of its subtree.
+ * This allows items to be inserted, removed, moved, and located by index in O(log n) time,
+ * instead of the O(n) time required by QList::insert(), QList::removeAll(), and
+ * QList::indexOf().
+ *
+ * Use toList() to retrieve the items in order.
+ *
+ * DrawingSceneOrder does not take ownership of any items.
+ */
+class DrawingSceneOrder
+{
+private:
+	struct Node
+	{
+		DrawingItem* item;
+		Node* left;
+		Node* right;
+		Node* parent;
+		int size;
+		quint32 priority;
+	};
+
+	Node* mRoot;
+	QHash<DrawingItem*,Node*> mNodes;
+	quint32 mSeed;
+
+public:
+	//! \brief Create a new, empty DrawingSceneOrder.
+	DrawingSceneOrder();
+
+	//! \brief Delete an existing DrawingSceneOrder object.
+	~DrawingSceneOrder();
+
+
+	/*! \brief Inserts the item at the specified index.
+	 *
+	 * The index is clamped to the range [0, size()].  This function does nothing if the item is
+	 * already in the list.
+	 *
+	 * \sa append(), remove()
+	 */
+	void insert(int index, DrawingItem* item);
+
+	/*! \brief Adds the item to the end of the list.
+	 *
+	 * This convenience function is equivalent to calling insert(size(), item).
+	 */
+	void append(DrawingItem* item);
+
+	/*! \brief Removes the item from the list.
+	 *
+	 * This function does nothing if the item is not in the list.
+	 *
+	 * \sa insert(), clear()
+	 */
+	void remove(DrawingItem* item);
+
+	/*! \brief Moves the item so that it is at the specified index.
+	 *
+	 * This is equivalent to calling remove() followed by insert().
+	 */
+	void move(DrawingItem* item, int index);
+
+	/*! \brief Removes all items from the list.
+	 */
+	void clear();
+
+
+	/*! \brief Returns true if the item is in the list, false otherwise.
+	 */
+	bool contains(DrawingItem* item) const;
+
+	/*! \brief Returns the index of the item within the list, or -1 if the item is not in the
+	 * list.
+	 */
+	int indexOf(DrawingItem* item) const;
+
+	/*! \brief Returns the item at the specified index, or nullptr if the index is out of range.
+	 */
+	DrawingItem* at(int index) const;
+
+	/*! \brief Returns the number of items in the list.
+	 */
+	int size() const;
+
+	/*! \brief Returns all of the items in the list, in order.
+	 */
+	QList<DrawingItem*> toList() const;
+
+private:
+	Q_DISABLE_COPY(DrawingSceneOrder)
+
+	quint32 nextPriority();
+	void deleteNodes(Node* node);
+	void appendNodes(Node* node, QList<DrawingItem*>& items) const;
+
+	static int nodeSize(Node* node);
+	static void updateNode(Node* node);
+	static Node* merge(Node* left, Node* right);
+	static void split(Node* node, int index, Node*& left, Node*& right);
+};
+
+#endif
@@ -0,0 +1,120 @@
+/* DrawingSceneSnapshot.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGSCENESNAPSHOT_H
+#define DRAWINGSCENESNAPSHOT_H
+
+#include <QtGui>
+#include <DrawingDisplayList.h>
+
+/*! \brief Snapshot of the visible part of a DrawingScene that can be rendered on another thread.
+ *
+ * DrawingView uses a DrawingSceneSnapshot to render tiles on a background thread when the
+ * DrawingView::AsynchronousRendering flag is set.  The snapshot is an ordered list of the display
+ * lists of the visible items, each with the transform that maps it to the scene and its bounding
+ * rect in device coordinates.  Because each DrawingDisplayList shares its operations with the
+ * item's own display list, taking a snapshot does not copy or record any drawing operations,
+ * except for items that have changed since their display list was last used.
+ *
+ * Once taken, the snapshot does not refer to the scene or any of its items, so the scene is free
+ * to change while the snapshot is drawn.  A snapshot may be drawn from several threads at once.
+ */
+class DrawingSceneSnapshot
+{
+private:
+	struct Item
+	{
+		DrawingDisplayList displayList;
+		QTransform transform;
+		QRectF deviceRect;
+		QRectF placeholderRect;
+		QColor placeholderColor;
+	};
+
+	QTransform mTransform;
+	DrawingDisplayList mBackground;
+	QVector<Item> mItems;
+
+	qreal mMinimumRenderPenWidth;
+	qreal mMinimumTextSize;
+
+public:
+	/*! \brief Create a new, empty DrawingSceneSnapshot.
+	 *
+	 * The transform maps scene coordinates to the device coordinates that the snapshot will be
+	 * drawn in.
+	 */
+	DrawingSceneSnapshot(const QTransform& transform = QTransform());
+
+	//! \brief Delete an existing DrawingSceneSnapshot object.
+	~DrawingSceneSnapshot();
+
+
+	/*! \brief Returns the transform from scene coordinates to device coordinates.
+	 */
+	QTransform transform() const;
+
+	/*! \brief Sets the level-of-detail thresholds used when the items are drawn.
+	 *
+	 * These are passed to DrawingDisplayList::draw() for each item.
+	 */
+	void setLevelOfDetail(qreal minimumRenderPenWidth, qreal minimumTextSize);
+
+
+	/*! \brief Returns a display list that is drawn below all of the items.
+	 *
+	 * Anything recorded into the background is drawn in device coordinates, and is not culled
+	 * against the area being drawn.
+	 */
+	DrawingDisplayList* background();
+
+	/*! \brief Adds an item's display list to the top of the snapshot.
+	 *
+	 * The transform maps the display list to scene coordinates, and sceneRect is the item's
+	 * bounding rect in scene coordinates.
+	 */
+	void addItem(const DrawingDisplayList& displayList, const QTransform& transform,
+		const QRectF& sceneRect);
+
+	/*! \brief Adds a filled rect to the top of the snapshot in place of an item.
+	 *
+	 * The transform maps the rect to scene coordinates.
+	 */
+	void addPlaceholder(const QRectF& rect, const QColor& color, const QTransform& transform);
+
+	/*! \brief Returns the number of items in the snapshot, including placeholders.
+	 */
+	int itemCount() const;
+
+
+	/*! \brief Draws the part of the snapshot within deviceRect onto the specified painter.
+	 *
+	 * The painter's transform must map device coordinates to the painter's device, and is
+	 * restored afterwards.  Only the items whose device bounding rect intersects deviceRect are
+	 * drawn.  Consecutive items are combined into batches, in the same way as
+	 * DrawingScene::drawItems().
+	 */
+	void draw(QPainter* painter, const QRectF& deviceRect) const;
+
+private:
+	static bool rectsIntersect(const QRectF& rect1, const QRectF& rect2);
+};
+
+#endif
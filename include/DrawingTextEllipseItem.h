@@ -22,6 +22,7 @@
 #define DRAWINGTEXTELLIPSEITEM_H
 
 #include <DrawingItem.h>
+#include <DrawingTextLayout.h>
 
 /*! \brief Provides a text ellipse item that can be added to a DrawingScene.
  *
@@ -43,6 +44,7 @@ private:
 	enum PointIndex { TopLeft, BottomRight, TopRight, BottomLeft, TopMiddle, MiddleRight, BottomMiddle, MiddleLeft };
 
 	QString mCaption;
+	mutable DrawingTextLayout mTextLayout;
 
 public:
 	/*! \brief Create a new DrawingTextEllipseItem with default settings.
@@ -22,6 +22,7 @@
 #define DRAWINGTEXTITEM_H
 
 #include <DrawingItem.h>
+#include <DrawingTextLayout.h>
 
 /*! \brief Provides a text item that can be added to a DrawingScene.
  *
@@ -38,6 +39,7 @@ class DrawingTextItem : public DrawingItem
 {
 private:
 	QString mCaption;
+	mutable DrawingTextLayout mTextLayout;
 
 public:
 	/*! \brief Create a new DrawingTextItem with default settings.
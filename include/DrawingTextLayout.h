@@ -0,0 +1,91 @@
+/* DrawingTextLayout.h
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef DRAWINGTEXTLAYOUT_H
+#define DRAWINGTEXTLAYOUT_H
+
+#include <QtGui>
+
+/*! \brief Caches the measured size and laid-out text of an item's caption.
+ *
+ * DrawingTextItem, DrawingTextRectItem, DrawingTextEllipseItem, and DrawingTextPolygonItem each
+ * keep a DrawingTextLayout so that the caption is not split into lines and measured every time
+ * the item's boundingRect(), shape(), or render() function is called.
+ *
+ * size() returns the size of the caption in the item's font.  The result is cached until the
+ * caption or font changes.
+ *
+ * draw() paints the caption using a QStaticText object for each line, which keeps the glyph
+ * layout between paints.  The layout is cached until the caption or the painter's font changes;
+ * since items scale their font based on the logical DPI of the paint device, this also covers
+ * changes to the device DPI.
+ *
+ * Items may be rendered from several threads at once, so access to the cached values is
+ * serialized with a mutex.
+ */
+class DrawingTextLayout
+{
+private:
+	QString mSizeCaption;
+	QFont mSizeFont;
+	QSizeF mSize;
+	bool mSizeValid;
+
+	QString mDrawCaption;
+	QFont mDrawFont;
+	QVector<QStaticText> mDrawLines;
+	qreal mDrawLineSpacing;
+	qreal mDrawLeading;
+	bool mDrawValid;
+
+	QMutex mMutex;
+
+public:
+	//! \brief Create a new, empty DrawingTextLayout.
+	DrawingTextLayout();
+
+	//! \brief Delete an existing DrawingTextLayout object.
+	~DrawingTextLayout();
+
+
+	/*! \brief Returns the size of the caption when drawn using the specified font.
+	 *
+	 * The width is the width of the longest line of the caption.  The height is the line spacing
+	 * of the font times the number of lines, less the leading of the last line.
+	 */
+	QSizeF size(const QString& caption, const QFont& font);
+
+	/*! \brief Draws the caption aligned within the specified rect.
+	 *
+	 * The caption is drawn using the painter's current font and pen.  Each line is aligned
+	 * horizontally within the rect, and the lines as a whole are aligned vertically within the
+	 * rect, in the same way as QPainter::drawText().
+	 */
+	void draw(QPainter* painter, const QRectF& rect, Qt::Alignment alignment, const QString& caption);
+
+	/*! \brief Discards all cached values.
+	 */
+	void clear();
+
+private:
+	Q_DISABLE_COPY(DrawingTextLayout)
+};
+
+#endif
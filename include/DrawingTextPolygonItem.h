@@ -22,6 +22,7 @@
 #define DRAWINGTEXTPOLYGONITEM_H
 
 #include <DrawingItem.h>
+#include <DrawingTextLayout.h>
 
 /*! \brief Provides a text polygon item that can be added to a DrawingScene.
  *
@@ -41,6 +42,7 @@ class DrawingTextPolygonItem : public DrawingItem
 {
 private:
 	QString mCaption;
+	mutable DrawingTextLayout mTextLayout;
 
 public:
 	/*! \brief Create a new DrawingTextPolygonItem with default settings.
@@ -22,6 +22,7 @@
 #define DRAWINGTEXTRECTITEM_H
 
 #include <DrawingItem.h>
+#include <DrawingTextLayout.h>
 
 /*! \brief Provides a text rectangle item that can be added to a DrawingScene.
  *
@@ -44,6 +45,7 @@ private:
 
 	qreal mCornerRadiusX, mCornerRadiusY;
 	QString mCaption;
+	mutable DrawingTextLayout mTextLayout;
 
 public:
 	/*! \brief Create a new DrawingTextRectItem with default settings.
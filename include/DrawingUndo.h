@@ -220,12 +220,13 @@ class DrawingReorderItemsCommand : public DrawingUndoCommand
 {
 private:
 	DrawingScene* mScene;
-	QList<DrawingItem*> mNewItemOrder;
-	QList<DrawingItem*> mOriginalItemOrder;
+	QList<DrawingItem*> mItems;
+	QHash<DrawingItem*,int> mNewIndices;
+	QHash<DrawingItem*,int> mOriginalIndices;
 
 public:
-	DrawingReorderItemsCommand(DrawingScene* scene,
-		const QList<DrawingItem*>& newItemOrder, QUndoCommand* parent = nullptr);
+	DrawingReorderItemsCommand(DrawingScene* scene, const QList<DrawingItem*>& items,
+		const QHash<DrawingItem*,int>& newIndices, QUndoCommand* parent = nullptr);
 	~DrawingReorderItemsCommand();
 
 	int id() const;
@@ -26,6 +26,7 @@
 class DrawingScene;
 class DrawingItem;
 class DrawingItemPoint;
+class DrawingSceneSnapshot;
 
 /*! \brief Widget for viewing the contents of a DrawingScene.
  *
@@ -142,14 +143,46 @@ public:
 											//!< for the scene.
 		UndoableSelectCommands = 0x0002,	//!< Selecting and deselecting items are commands that
 											//!< the user can undo() and redo().
-		SendsMouseMoveInfo = 0x0004			//!< Emits the mouseInfoChanged() signal when the mouse
+		SendsMouseMoveInfo = 0x0004,		//!< Emits the mouseInfoChanged() signal when the mouse
 											//!< is moved within the scene.
+		SingleThreadedRendering = 0x0008,	//!< Renders the scene one tile at a time on the GUI
+											//!< thread.  If this flag is not set, tiles are
+											//!< rendered in parallel on QThreadPool::globalInstance().
+		InteractiveZoom = 0x0010,			//!< When the zoom level changes, the previously
+											//!< rendered tiles are scaled to the new zoom level
+											//!< instead of rendering the scene again.  The scene is
+											//!< rendered at the new zoom level once the view has not
+											//!< been zoomed for interactiveZoomDelay().
+		ProgressiveRendering = 0x0020,		//!< Each paint event only renders as many tiles as fit
+											//!< within renderTimeBudget(), starting with the tiles
+											//!< nearest the mouse cursor.  The remaining tiles are
+											//!< rendered in later paint events.
+		AsynchronousRendering = 0x0040,		//!< Tiles are rendered on a background thread from a
+											//!< snapshot of the visible part of the scene, and the
+											//!< previously rendered tiles are shown until they are
+											//!< ready.  Paint events never wait for the scene to be
+											//!< rendered.  This flag takes precedence over
+											//!< #ProgressiveRendering.  It is ignored if
+											//!< QFontDatabase::supportsThreadedFontRendering()
+											//!< returns false.
+		AdaptiveAntialiasing = 0x0080		//!< While the user drags, scrolls, zooms, or places
+											//!< items, the scene is rendered without antialiasing
+											//!< (text is still antialiased).  The affected tiles are
+											//!< rendered again with antialiasing once the
+											//!< interaction ends or the input has been idle for
+											//!< adaptiveAntialiasingDelay().
 	};
 	Q_DECLARE_FLAGS(Flags, Flag)
 
 private:
 	enum MouseState { MouseReady, MouseSelect, MouseMoveItems, MouseResizeItem, MouseRubberBand };
 
+	struct RenderTile
+	{
+		QRect rect;
+		QImage image;
+	};
+
 private:
 	DrawingScene* mScene;
 
@@ -157,6 +190,12 @@ private:
 	Qt::ItemSelectionMode mItemSelectionMode;
 	qreal mGrid;
 
+	qreal mMinimumTextSize;
+	qreal mMinimumDetailSize;
+	qreal mMinimumItemSize;
+	qreal mMinimumRenderPenWidth;
+	qreal mOverviewScale;
+
 	QUndoStack mUndoStack;
 
 	Mode mMode;
@@ -190,6 +229,29 @@ private:
 	QPoint mPanCurrentPos;
 	QTimer mPanTimer;
 
+	QCache<quint64,QImage> mRenderTiles;
+	QTransform mRenderTilesTransform;
+
+	QTimer mZoomTimer;
+	QTransform mZoomPreviewTransform;
+
+	int mRenderTimeBudget;
+	QRegion mPendingRenderRegion;
+	QElapsedTimer mRenderPassTimer;
+	int mRenderPassTileCount;
+
+	QFutureWatcher<QVector<RenderTile>> mRenderWatcher;
+	QTransform mAsyncRenderTransform;
+	QSet<quint64> mAsyncRenderTiles;
+	bool mAsyncRenderStale;
+	bool mAsyncRenderReduced;
+	QAtomicInt mAsyncRenderCancelled;
+
+	QTimer mInteractionTimer;
+	bool mInteractionActive;
+	QSet<quint64> mReducedQualityTiles;
+	QSet<quint64> mStaleRenderTiles;
+
 public:
 	/*! \brief Create a new DrawingView with default settings.
 	 *
@@ -299,6 +361,156 @@ public:
 	QPointF roundToGrid(const QPointF& scenePos) const;
 
 
+	/*! \brief Sets the smallest size of text, in pixels, that is drawn by the view.
+	 *
+	 * Items skip drawing text whose font size would be less than this many pixels high at the
+	 * view's current scale.  Set to 0 to always draw text.
+	 *
+	 * The default minimum text size is 4 pixels.
+	 *
+	 * \sa minimumTextSize(), DrawingItem::isTextVisible()
+	 */
+	void setMinimumTextSize(qreal pixels);
+
+	/*! \brief Returns the smallest size of text, in pixels, that is drawn by the view.
+	 *
+	 * \sa setMinimumTextSize()
+	 */
+	qreal minimumTextSize() const;
+
+	/*! \brief Sets the smallest size of item details, in pixels, that are drawn by the view.
+	 *
+	 * Items skip drawing details such as arrowheads and control lines that would be smaller than
+	 * this many pixels at the view's current scale.  Set to 0 to always draw details.
+	 *
+	 * The default minimum detail size is 3 pixels.
+	 *
+	 * \sa minimumDetailSize(), DrawingItem::isDetailVisible()
+	 */
+	void setMinimumDetailSize(qreal pixels);
+
+	/*! \brief Returns the smallest size of item details, in pixels, that are drawn by the view.
+	 *
+	 * \sa setMinimumDetailSize()
+	 */
+	qreal minimumDetailSize() const;
+
+	/*! \brief Sets the smallest size of items, in pixels, that are fully rendered by the view.
+	 *
+	 * Items whose width and height would both be smaller than this many pixels at the view's
+	 * current scale are drawn as a small box in the item's pen color instead of being rendered.
+	 * Set to 0 to always render items.
+	 *
+	 * The default minimum item size is 2 pixels.
+	 *
+	 * \sa minimumItemSize()
+	 */
+	void setMinimumItemSize(qreal pixels);
+
+	/*! \brief Returns the smallest size of items, in pixels, that are fully rendered by the view.
+	 *
+	 * \sa setMinimumItemSize()
+	 */
+	qreal minimumItemSize() const;
+
+	/*! \brief Sets the smallest pen width, in pixels, that is drawn as a scaled pen by the view.
+	 *
+	 * Pens that would be narrower than this many pixels at the view's current scale are drawn
+	 * as cosmetic pens one pixel wide instead, which are much faster to draw.  Set to 0 to always
+	 * draw pens at their scaled width.
+	 *
+	 * The default minimum pen width is 1 pixel.
+	 *
+	 * \sa minimumRenderPenWidth(), DrawingItem::renderPen()
+	 */
+	void setMinimumRenderPenWidth(qreal pixels);
+
+	/*! \brief Returns the smallest pen width, in pixels, that is drawn as a scaled pen by the view.
+	 *
+	 * \sa setMinimumRenderPenWidth()
+	 */
+	qreal minimumRenderPenWidth() const;
+
+	/*! \brief Sets the scale below which the view draws an overview of the scene instead of its
+	 * individual items.
+	 *
+	 * The scale is the number of pixels per scene unit.  Below this scale, drawItems() calls
+	 * DrawingScene::drawOverview() instead of DrawingScene::drawItems().  Set to 0 to always draw
+	 * the individual items.
+	 *
+	 * The default overview scale is 0.02.
+	 *
+	 * \sa overviewScale()
+	 */
+	void setOverviewScale(qreal scale);
+
+	/*! \brief Returns the scale below which the view draws an overview of the scene instead of its
+	 * individual items.
+	 *
+	 * \sa setOverviewScale()
+	 */
+	qreal overviewScale() const;
+
+	/*! \brief Sets the time, in milliseconds, that the view waits after the last zoom before
+	 * rendering the scene at the new zoom level.
+	 *
+	 * This setting only has an effect if the #InteractiveZoom flag is set.  Until then, the view
+	 * shows its previously rendered tiles scaled to the new zoom level, so that zooming repeatedly
+	 * (such as with the mouse wheel) does not render the scene for every step.
+	 *
+	 * The default delay is 250 milliseconds.
+	 *
+	 * \sa interactiveZoomDelay()
+	 */
+	void setInteractiveZoomDelay(int msec);
+
+	/*! \brief Returns the time, in milliseconds, that the view waits after the last zoom before
+	 * rendering the scene at the new zoom level.
+	 *
+	 * \sa setInteractiveZoomDelay()
+	 */
+	int interactiveZoomDelay() const;
+
+	/*! \brief Sets the time, in milliseconds, that each paint event may spend rendering tiles.
+	 *
+	 * This setting only has an effect if the #ProgressiveRendering flag is set.  Tiles are rendered
+	 * in groups (one tile per thread) until the budget is used up, so a paint event may exceed the
+	 * budget by the time needed to render one group.  Tiles that were not rendered are left empty
+	 * and rendered in the following paint events, which are scheduled automatically.
+	 *
+	 * The default budget is 16 milliseconds.
+	 *
+	 * \sa renderTimeBudget(), renderingFinished()
+	 */
+	void setRenderTimeBudget(int msec);
+
+	/*! \brief Returns the time, in milliseconds, that each paint event may spend rendering tiles.
+	 *
+	 * \sa setRenderTimeBudget()
+	 */
+	int renderTimeBudget() const;
+
+	/*! \brief Sets the time, in milliseconds, without any input after which an interaction is
+	 * considered finished.
+	 *
+	 * This setting only has an effect if the #AdaptiveAntialiasing flag is set.  Tiles rendered
+	 * without antialiasing during the interaction are rendered again with antialiasing once this
+	 * time has elapsed, or as soon as the mouse button is released.
+	 *
+	 * The default delay is 250 milliseconds.
+	 *
+	 * \sa adaptiveAntialiasingDelay()
+	 */
+	void setAdaptiveAntialiasingDelay(int msec);
+
+	/*! \brief Returns the time, in milliseconds, without any input after which an interaction is
+	 * considered finished.
+	 *
+	 * \sa setAdaptiveAntialiasingDelay()
+	 */
+	int adaptiveAntialiasingDelay() const;
+
+
 	/*! \brief Set the maximum depth of the internal undo stack of the view.
 	 *
 	 * When the number of commands on the stack exceeds the undo limit, commands are deleted from
@@ -590,6 +802,30 @@ public:
 	 */
 	virtual void render(QPainter* painter);
 
+	/*! \brief Renders the specified area of the scene into a new image of the specified size.
+	 *
+	 * The image is split into tiles which are rendered using drawBackground() and drawItems().
+	 * Unless the #SingleThreadedRendering flag is set, the tiles are rendered in parallel.  Areas
+	 * of the image that are not covered by the scene's background are left transparent.
+	 *
+	 * \sa render()
+	 */
+	QImage renderImage(const QRectF& sceneRect, const QSize& imageSize);
+
+	/*! \brief Discards the view's cached rendering of the scene.
+	 *
+	 * DrawingView caches the rendered scene in tiles so that scrolling and repainting the viewport
+	 * do not require the scene to be rendered again.  The tiles of items that are moved, resized,
+	 * rotated, flipped, shown, or hidden through the scene are invalidated as soon as the scene's
+	 * itemsPositionChanged(), itemsGeometryChanged(), itemsTransformChanged(), and
+	 * itemsVisibilityChanged() signals are emitted.  Any other change, including direct changes
+	 * to an item or its DrawingItemStyle, is picked up through the DrawingScene::changed() signal
+	 * before the next paint, and the cache is also updated whenever the view is zoomed.  Call
+	 * this function when a reimplementation of drawBackground() or drawItems() needs to draw
+	 * something different.
+	 */
+	void resetCachedContent();
+
 public slots:
 	/*! \brief Zooms in on the scene.
 	 *
@@ -1094,6 +1330,20 @@ signals:
 	 */
 	void scaleChanged(qreal scale);
 
+	/*! \brief Emitted when all of the tiles in the visible area of the view have been rendered.
+	 *
+	 * The tileCount is the number of tiles that were rendered, and msec is the time from the start
+	 * of the first paint event that rendered any of them.  If the #ProgressiveRendering flag is
+	 * set, this may span several paint events; otherwise, it is the time spent rendering tiles in
+	 * a single paint event.  If the #AsynchronousRendering flag is set, this signal is emitted
+	 * each time a frame rendered on the background thread is shown, and msec includes the time
+	 * taken to capture the snapshot of the scene.
+	 *
+	 * This signal is not emitted for paint events that could use cached tiles for the entire
+	 * visible area.
+	 */
+	void renderingFinished(int tileCount, int msec);
+
 	/*! \brief Emitted whenever the operating mode of the view changes.
 	 *
 	 * This signal is emitted whenever the mode is changed using the setDefaultMode(),
@@ -1216,6 +1466,27 @@ protected:
 	 *
 	 * The default implementation calls drawBackground(), drawItems(), and drawForeground() in
 	 * succession.
+	 *
+	 * The scene content drawn by drawBackground() and drawItems() is rendered into fixed-size tiles
+	 * at the current zoom level, which are cached and reused until the part of the scene they
+	 * cover changes.  The interaction overlay drawn by drawForeground() is drawn over the tiles on
+	 * every paint.  Only the tiles under the rects of the paint event's region are drawn.  If the
+	 * #InteractiveZoom flag is set and the zoom level has changed, the previously rendered tiles
+	 * are scaled to the new zoom level instead, until interactiveZoomDelay() has elapsed.
+	 *
+	 * Unless the #SingleThreadedRendering flag is set, tiles that need to be rendered are rendered
+	 * in parallel on QThreadPool::globalInstance().  In this case, drawBackground(), drawItems(),
+	 * and the DrawingItem::render() implementation of every item in the scene may be called from
+	 * several threads at once, and must not modify the scene or any item.  Tiles are always
+	 * rendered on the GUI thread if QFontDatabase::supportsThreadedFontRendering() returns false.
+	 *
+	 * If the #AsynchronousRendering flag is set, the visible part of the scene is instead captured
+	 * on the GUI thread in a DrawingSceneSnapshot, which is then rendered into tiles on a
+	 * background thread.  The snapshot shares each visible item's DrawingItem::displayList(), so
+	 * only drawBackground() (and drawItems(), if the scene is drawn as an overview) is called to
+	 * take it; otherwise drawItems() is not called.  Until the new tiles are ready, the paint
+	 * event draws the previously rendered tiles (scaled, if the zoom level has changed) and
+	 * leaves any area without tiles empty.
 	 */
 	virtual void paintEvent(QPaintEvent* event);
 
@@ -1225,6 +1496,16 @@ protected:
 	 */
 	virtual void resizeEvent(QResizeEvent* event);
 
+	/*! \brief Handles changes to the scroll bar values of the view.
+	 *
+	 * Scrolling the view with the scroll bars, middle-button panning, or centerOn() only
+	 * translates the scene, so the default implementation shifts the previous contents of the
+	 * viewport by dx and dy and only repaints the strips that were scrolled into view.  The
+	 * entire viewport is repainted instead if the zoom level changed since the last paint or if
+	 * the rubber band, which is drawn in viewport coordinates, is visible.
+	 */
+	virtual void scrollContentsBy(int dx, int dy);
+
 
 	/*! \brief Handles mouse press events for the view.
 	 *
@@ -1309,7 +1590,8 @@ protected:
 
 	/*! \brief Renders the widget's items into the scene using the specified painter.
 	 *
-	 * The default implementation simply calls DrawingScene::drawItems().
+	 * The default implementation calls DrawingScene::drawItems(), or DrawingScene::drawOverview()
+	 * if the scene is being drawn at a scale below overviewScale().
 	 *
 	 * This function may be overridden in a derived class to provide a custom rendering
 	 * implementation for items in the scene.
@@ -1326,7 +1608,9 @@ protected:
 	 * This function handles rendering of any newItems() set on the view, the points of any item
 	 * that is selected, and the rubber band selection rect.
 	 *
-	 * This function is called after rendering the widget's items.
+	 * This function is called after rendering the widget's items.  Unlike drawBackground() and
+	 * drawItems(), its output is not cached; it is called on every paint event, so it should only
+	 * draw things that change frequently during user interaction.
 	 *
 	 * \sa drawBackground(), drawItems()
 	 */
@@ -1335,6 +1619,12 @@ protected:
 private slots:
 	void updateSelectionCenter();
 	void mousePanEvent();
+	void invalidateRenderTiles(const QList<QRectF>& sceneRects);
+	void invalidateItemRenderTiles(const QList<DrawingItem*>& items);
+	void finishInteractiveZoom();
+	void continueProgressiveRendering();
+	void finishAsynchronousRender();
+	void finishInteraction();
 
 private:
 	void addItemsCommand(const QList<DrawingItem*>& items, bool place, QUndoCommand* command = nullptr);
@@ -1347,7 +1637,8 @@ private:
 	void rotateBackItemsCommand(const QList<DrawingItem*>& items, const QPointF& scenePos, QUndoCommand* command = nullptr);
 	void flipItemsHorizontalCommand(const QList<DrawingItem*>& items, const QPointF& scenePos, QUndoCommand* command = nullptr);
 	void flipItemsVerticalCommand(const QList<DrawingItem*>& items, const QPointF& scenePos, QUndoCommand* command = nullptr);
-	void reorderItemsCommand(const QList<DrawingItem*>& itemsOrdered, QUndoCommand* command = nullptr);
+	void reorderItemsCommand(const QList<DrawingItem*>& items, const QHash<DrawingItem*,int>& newIndex,
+		QUndoCommand* command = nullptr);
 	void selectItemsCommand(const QList<DrawingItem*>& items, bool finalSelect = true, QUndoCommand* command = nullptr);
 	void connectItemPointsCommand(DrawingItemPoint* point1, DrawingItemPoint* point2, QUndoCommand* command = nullptr);
 	void disconnectItemPointsCommand(DrawingItemPoint* point1, DrawingItemPoint* point2, QUndoCommand* command = nullptr);
@@ -1362,6 +1653,23 @@ private:
 private:
 	void recalculateContentSize(const QRectF& targetSceneRect = QRectF());
 
+	void renderTiles(QVector<RenderTile>& tiles, const QTransform& transform, const QColor& fillColor,
+		QPainter::RenderHints hints);
+	void renderTile(RenderTile& tile, const QTransform& transform, const QColor& fillColor,
+		QPainter::RenderHints hints);
+	void startAsynchronousRender(const QRect& contentRect);
+	static QVector<RenderTile> renderFrame(QVector<RenderTile> tiles,
+		QSharedPointer<DrawingSceneSnapshot> snapshot, QColor fillColor, QPainter::RenderHints hints,
+		const QAtomicInt* cancelled);
+	bool usesAsynchronousRendering() const;
+	void invalidateRenderTile(quint64 tileKey);
+	static quint64 renderTileKey(int column, int row);
+	void beginInteraction();
+	QPainter::RenderHints renderQualityHints() const;
+	void drawZoomPreview(QPainter* painter, const QPoint& scrollOffset);
+
+	QList<DrawingItem*> selectedItemsInOrder(QHash<DrawingItem*,int>& itemIndex) const;
+
 	qreal minimumPenWidth(DrawingItem* item) const;
 	QRect pointRect(DrawingItemPoint* point) const;
 	DrawingItemPoint* pointAt(DrawingItem* item, const QPointF& itemPos) const;
@@ -6,7 +6,7 @@ INCLUDEPATH += include
 
 CONFIG += release warn_on embed_manifest_dll c++11 qt staticlib
 CONFIG -= debug
-QT += widgets
+QT += widgets concurrent
 
 !win32:MOC_DIR = release
 !win32:OBJECTS_DIR = release
@@ -17,6 +17,7 @@ QT += widgets
 SOURCES += \
 	source/DrawingArcItem.cpp \
 	source/DrawingCurveItem.cpp \
+	source/DrawingDisplayList.cpp \
 	source/DrawingEllipseItem.cpp \
 	source/DrawingItem.cpp \
 	source/DrawingItemGroup.cpp \
@@ -28,16 +29,22 @@ SOURCES += \
 	source/DrawingPolylineItem.cpp \
 	source/DrawingRectItem.cpp \
 	source/DrawingTextItem.cpp \
+	source/DrawingTextLayout.cpp \
 	source/DrawingTextEllipseItem.cpp \
 	source/DrawingTextPolygonItem.cpp \
 	source/DrawingTextRectItem.cpp \
 	source/DrawingScene.cpp \
+	source/DrawingSceneDensity.cpp \
+	source/DrawingSceneIndex.cpp \
+	source/DrawingSceneOrder.cpp \
+	source/DrawingSceneSnapshot.cpp \
 	source/DrawingUndo.cpp \
 	source/DrawingView.cpp
 
 HEADERS += \
 	include/DrawingArcItem.h \
 	include/DrawingCurveItem.h \
+	include/DrawingDisplayList.h \
 	include/DrawingEllipseItem.h \
 	include/DrawingItem.h \
 	include/DrawingItemGroup.h \
@@ -49,10 +56,15 @@ HEADERS += \
 	include/DrawingPolylineItem.h \
 	include/DrawingRectItem.h \
 	include/DrawingTextItem.h \
+	include/DrawingTextLayout.h \
 	include/DrawingTextEllipseItem.h \
 	include/DrawingTextPolygonItem.h \
 	include/DrawingTextRectItem.h \
 	include/DrawingScene.h \
+	include/DrawingSceneDensity.h \
+	include/DrawingSceneIndex.h \
+	include/DrawingSceneOrder.h \
+	include/DrawingSceneSnapshot.h \
 	include/DrawingUndo.h \
 	include/DrawingView.h \
     include/Drawing.h
@@ -176,7 +176,7 @@ void DrawingArcItem::render(QPainter* painter)
 		qreal arcStartAngle = DrawingArcItem::arcStartAngle();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		DrawingItemStyle::ArrowStyle startArrowStyle = style->startArrowStyle();
 		DrawingItemStyle::ArrowStyle endArrowStyle = style->endArrowStyle();
 		qreal startArrowSize = style->startArrowSize();
@@ -194,9 +194,9 @@ void DrawingArcItem::render(QPainter* painter)
 		// Draw arrows
 		if (pen.style() != Qt::NoPen)
 		{
-			if (lineLength > startArrowSize)
+			if (lineLength > startArrowSize && isDetailVisible(painter, startArrowSize))
 				style->drawArrow(painter, startArrowStyle, startArrowSize, p1, startArrowAngle(), pen, sceneBrush);
-			if (lineLength > endArrowSize)
+			if (lineLength > endArrowSize && isDetailVisible(painter, endArrowSize))
 				style->drawArrow(painter, endArrowStyle, endArrowSize, p2, endArrowAngle(), pen, sceneBrush);
 		}
 
@@ -176,7 +176,7 @@ void DrawingCurveItem::render(QPainter* painter)
 		qreal lineLength = qSqrt((p2.x() - p1.x()) * (p2.x() - p1.x()) + (p2.y() - p1.y()) * (p2.y() - p1.y()));
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		DrawingItemStyle::ArrowStyle startArrowStyle = style->startArrowStyle();
 		DrawingItemStyle::ArrowStyle endArrowStyle = style->endArrowStyle();
 		qreal startArrowSize = style->startArrowSize();
@@ -194,14 +194,14 @@ void DrawingCurveItem::render(QPainter* painter)
 		// Draw arrows
 		if (pen.style() != Qt::NoPen)
 		{
-			if (lineLength > startArrowSize)
+			if (lineLength > startArrowSize && isDetailVisible(painter, startArrowSize))
 				style->drawArrow(painter, startArrowStyle, startArrowSize, p1, startArrowAngle(), pen, sceneBrush);
-			if (lineLength > endArrowSize)
+			if (lineLength > endArrowSize && isDetailVisible(painter, endArrowSize))
 				style->drawArrow(painter, endArrowStyle, endArrowSize, p2, endArrowAngle(), pen, sceneBrush);
 		}
 
 		// Draw control lines
-		if (isSelected())
+		if (isSelected() && isDetailVisible(painter, lineLength))
 		{
 			pen.setStyle(Qt::DotLine);
 			pen.setWidthF(pen.widthF() * 0.75);
@@ -0,0 +1,546 @@
+/* DrawingDisplayList.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingDisplayList.h"
+
+// Paint engine that appends each primitive drawn by a QPainter to a DrawingDisplayList.  All
+// features are reported as supported so that QPainter passes the primitives and painter state
+// through unchanged instead of emulating them.
+class DrawingDisplayListEngine : public QPaintEngine
+{
+private:
+	DrawingDisplayList* mList;
+	DrawingDisplayList::State mState;
+	bool mStateChanged;
+
+public:
+	DrawingDisplayListEngine() : QPaintEngine(QPaintEngine::AllFeatures)
+	{
+		mList = nullptr;
+		mStateChanged = true;
+	}
+
+	bool begin(QPaintDevice* device)
+	{
+		mList = static_cast<DrawingDisplayList*>(device);
+
+		mState.pen = QPen();
+		mState.brush = QBrush();
+		mState.font = QFont();
+		mState.transform = QTransform();
+		mState.opacity = 1.0;
+		mStateChanged = true;
+
+		return true;
+	}
+
+	bool end()
+	{
+		mList = nullptr;
+		return true;
+	}
+
+	void updateState(const QPaintEngineState& state)
+	{
+		QPaintEngine::DirtyFlags flags = state.state();
+
+		if (flags & QPaintEngine::DirtyPen) mState.pen = state.pen();
+		if (flags & QPaintEngine::DirtyBrush) mState.brush = state.brush();
+		if (flags & QPaintEngine::DirtyFont) mState.font = state.font();
+		if (flags & QPaintEngine::DirtyTransform) mState.transform = state.transform();
+		if (flags & QPaintEngine::DirtyOpacity) mState.opacity = state.opacity();
+
+		if (flags & (QPaintEngine::DirtyPen | QPaintEngine::DirtyBrush | QPaintEngine::DirtyFont |
+			QPaintEngine::DirtyTransform | QPaintEngine::DirtyOpacity))
+		{
+			mStateChanged = true;
+		}
+	}
+
+	void drawPath(const QPainterPath& path)
+	{
+		addOperation(DrawingDisplayList::PathOperation).path = path;
+	}
+
+	void drawLines(const QLineF* lines, int lineCount)
+	{
+		DrawingDisplayList::Operation& operation = addOperation(DrawingDisplayList::LinesOperation);
+
+		operation.points.reserve(2 * lineCount);
+		for(int i = 0; i < lineCount; i++)
+			operation.points << lines[i].p1() << lines[i].p2();
+	}
+
+	void drawPolygon(const QPointF* points, int pointCount, PolygonDrawMode mode)
+	{
+		DrawingDisplayList::OperationType type = DrawingDisplayList::PolygonOperation;
+		if (mode == QPaintEngine::WindingMode) type = DrawingDisplayList::WindingPolygonOperation;
+		else if (mode == QPaintEngine::PolylineMode) type = DrawingDisplayList::PolylineOperation;
+
+		DrawingDisplayList::Operation& operation = addOperation(type);
+
+		operation.points.reserve(pointCount);
+		for(int i = 0; i < pointCount; i++) operation.points.append(points[i]);
+	}
+
+	void drawPoints(const QPointF* points, int pointCount)
+	{
+		DrawingDisplayList::Operation& operation = addOperation(DrawingDisplayList::PointsOperation);
+
+		operation.points.reserve(pointCount);
+		for(int i = 0; i < pointCount; i++) operation.points.append(points[i]);
+	}
+
+	void drawRects(const QRectF* rects, int rectCount)
+	{
+		for(int i = 0; i < rectCount; i++)
+			addOperation(DrawingDisplayList::RectOperation).rect = rects[i];
+	}
+
+	void drawEllipse(const QRectF& rect)
+	{
+		addOperation(DrawingDisplayList::EllipseOperation).rect = rect;
+	}
+
+	void drawTextItem(const QPointF& p, const QTextItem& textItem)
+	{
+		if (mState.font != textItem.font())
+		{
+			mState.font = textItem.font();
+			mStateChanged = true;
+		}
+
+		// The text is positioned at its baseline, as in QPainter::drawText(const QPointF&, ...)
+		DrawingDisplayList::Operation& operation = addOperation(DrawingDisplayList::TextOperation);
+		operation.rect = QRectF(p, QSizeF());
+		operation.text = textItem.text();
+	}
+
+	void drawPixmap(const QRectF& rect, const QPixmap& pixmap, const QRectF& sourceRect)
+	{
+		// Images are stored rather than pixmaps so that the list can be replayed on any thread
+		DrawingDisplayList::Operation& operation = addOperation(DrawingDisplayList::ImageOperation);
+		operation.rect = rect;
+		operation.sourceRect = sourceRect;
+		operation.image = pixmap.toImage();
+	}
+
+	void drawImage(const QRectF& rect, const QImage& image, const QRectF& sourceRect,
+		Qt::ImageConversionFlags flags)
+	{
+		Q_UNUSED(flags);
+
+		DrawingDisplayList::Operation& operation = addOperation(DrawingDisplayList::ImageOperation);
+		operation.rect = rect;
+		operation.sourceRect = sourceRect;
+		operation.image = image;
+	}
+
+	Type type() const
+	{
+		return QPaintEngine::User;
+	}
+
+private:
+	DrawingDisplayList::Operation& addOperation(DrawingDisplayList::OperationType type)
+	{
+		if (mStateChanged)
+		{
+			mList->mStates.append(mState);
+			mStateChanged = false;
+		}
+
+		DrawingDisplayList::Operation operation;
+		operation.type = type;
+		operation.stateIndex = mList->mStates.size() - 1;
+		mList->mOperations.append(operation);
+
+		return mList->mOperations.last();
+	}
+};
+
+//==================================================================================================
+
+DrawingDisplayList::DrawingDisplayList() : QPaintDevice()
+{
+	mEngine = nullptr;
+}
+
+DrawingDisplayList::DrawingDisplayList(const DrawingDisplayList& list) : QPaintDevice()
+{
+	mStates = list.mStates;
+	mOperations = list.mOperations;
+	mEngine = nullptr;
+}
+
+DrawingDisplayList::~DrawingDisplayList()
+{
+	delete mEngine;
+}
+
+//==================================================================================================
+
+DrawingDisplayList& DrawingDisplayList::operator=(const DrawingDisplayList& list)
+{
+	mStates = list.mStates;
+	mOperations = list.mOperations;
+	return *this;
+}
+
+//==================================================================================================
+
+void DrawingDisplayList::draw(QPainter* painter, qreal minimumPenWidth, qreal minimumTextSize) const
+{
+	if (painter && !mOperations.isEmpty())
+	{
+		QPen scenePen = painter->pen();
+		QBrush sceneBrush = painter->brush();
+		QFont sceneFont = painter->font();
+		qreal sceneOpacity = painter->opacity();
+		QTransform sceneTransform = painter->transform();
+
+		// The list is recorded at 96 DPI, so scale the fonts to the resolution of the device
+		qreal fontScale = 1.0;
+		if (painter->device() && painter->device()->logicalDpiX() > 0)
+			fontScale = 96.0 / painter->device()->logicalDpiX();
+
+		int stateIndex = -1;
+		bool textVisible = true;
+
+		for(auto operationIter = mOperations.begin(); operationIter != mOperations.end(); operationIter++)
+		{
+			if (operationIter->stateIndex != stateIndex)
+			{
+				const State& state = mStates[operationIter->stateIndex];
+
+				painter->setTransform(state.transform * sceneTransform);
+				qreal scale = qSqrt(qAbs(painter->combinedTransform().determinant()));
+
+				// A zero-width pen is drawn one pixel wide regardless of the painter's transform
+				QPen pen = state.pen;
+				if (pen.style() != Qt::NoPen && !pen.isCosmetic() && pen.widthF() * scale < minimumPenWidth)
+					pen.setWidthF(0);
+
+				QFont font = state.font;
+				qreal fontSize = font.pointSizeF();
+				if (fontSize > 0) font.setPointSizeF(fontSize * fontScale);
+				else fontSize = font.pixelSize();
+				textVisible = (fontSize * scale >= minimumTextSize);
+
+				painter->setPen(pen);
+				painter->setBrush(state.brush);
+				painter->setFont(font);
+				painter->setOpacity(sceneOpacity * state.opacity);
+
+				stateIndex = operationIter->stateIndex;
+			}
+
+			switch (operationIter->type)
+			{
+			case PathOperation:
+				painter->drawPath(operationIter->path);
+				break;
+			case LinesOperation:
+				painter->drawLines(operationIter->points.constData(), operationIter->points.size() / 2);
+				break;
+			case PolygonOperation:
+				painter->drawPolygon(operationIter->points, Qt::OddEvenFill);
+				break;
+			case WindingPolygonOperation:
+				painter->drawPolygon(operationIter->points, Qt::WindingFill);
+				break;
+			case PolylineOperation:
+				painter->drawPolyline(operationIter->points);
+				break;
+			case PointsOperation:
+				painter->drawPoints(operationIter->points);
+				break;
+			case RectOperation:
+				painter->drawRect(operationIter->rect);
+				break;
+			case EllipseOperation:
+				painter->drawEllipse(operationIter->rect);
+				break;
+			case TextOperation:
+				if (textVisible) painter->drawText(operationIter->rect.topLeft(), operationIter->text);
+				break;
+			case ImageOperation:
+				painter->drawImage(operationIter->rect, operationIter->image, operationIter->sourceRect);
+				break;
+			default:
+				break;
+			}
+		}
+
+		painter->setTransform(sceneTransform);
+		painter->setPen(scenePen);
+		painter->setBrush(sceneBrush);
+		painter->setFont(sceneFont);
+		painter->setOpacity(sceneOpacity);
+	}
+}
+
+void DrawingDisplayList::clear()
+{
+	mStates.clear();
+	mOperations.clear();
+}
+
+bool DrawingDisplayList::isEmpty() const
+{
+	return mOperations.isEmpty();
+}
+
+int DrawingDisplayList::operationCount() const
+{
+	return mOperations.size();
+}
+
+//==================================================================================================
+
+QPaintEngine* DrawingDisplayList::paintEngine() const
+{
+	if (mEngine == nullptr) mEngine = new DrawingDisplayListEngine();
+	return mEngine;
+}
+
+int DrawingDisplayList::metric(PaintDeviceMetric metric) const
+{
+	int value = 0;
+
+	switch (metric)
+	{
+	case PdmWidth:
+	case PdmHeight:
+	case PdmWidthMM:
+	case PdmHeightMM:
+		// The list is not limited to any particular area
+		value = 0;
+		break;
+	case PdmDpiX:
+	case PdmDpiY:
+	case PdmPhysicalDpiX:
+	case PdmPhysicalDpiY:
+		value = 96;
+		break;
+	case PdmNumColors:
+		value = 16777216;
+		break;
+	case PdmDepth:
+		value = 24;
+		break;
+	default:
+		value = QPaintDevice::metric(metric);
+		break;
+	}
+
+	return value;
+}
+
+//==================================================================================================
+
+DrawingDisplayListBatch::DrawingDisplayListBatch()
+{
+	mType = NoBatch;
+}
+
+DrawingDisplayListBatch::~DrawingDisplayListBatch() { }
+
+//==================================================================================================
+
+bool DrawingDisplayListBatch::add(const DrawingDisplayList& displayList, const QTransform& transform)
+{
+	bool added = false;
+
+	if (displayList.mOperations.size() == 1)
+	{
+		const DrawingDisplayList::Operation& operation = displayList.mOperations.first();
+		const DrawingDisplayList::State& state = displayList.mStates[operation.stateIndex];
+		QTransform operationTransform = state.transform * transform;
+		BatchType type = NoBatch;
+
+		if (state.opacity == 1.0)
+		{
+			if (operation.type == DrawingDisplayList::LinesOperation && isOpaqueSolidPen(state.pen))
+			{
+				type = LinesBatch;
+			}
+			else if (operation.type == DrawingDisplayList::PathOperation && isOpaqueSolidPen(state.pen) &&
+				(state.brush.style() == Qt::NoBrush || state.brush.color().alpha() == 0) &&
+				isLineSegmentPath(operation.path))
+			{
+				type = LinesBatch;
+			}
+			else if (operation.type == DrawingDisplayList::RectOperation &&
+				operationTransform.type() <= QTransform::TxScale)
+			{
+				type = RectsBatch;
+			}
+		}
+
+		QRectF rect;
+		if (type == RectsBatch) rect = operationTransform.mapRect(operation.rect);
+
+		if (type != NoBatch && (mType == NoBatch ||
+			(mType == type && mPen == state.pen && (type != RectsBatch || mBrush == state.brush))) &&
+			(type != RectsBatch || !overlapsRects(rect)))
+		{
+			if (type == LinesBatch && operation.type == DrawingDisplayList::PathOperation)
+			{
+				const QPainterPath& path = operation.path;
+				for(int i = 1; i < path.elementCount(); i++)
+				{
+					if (path.elementAt(i).isLineTo())
+					{
+						mLinePoints.append(operationTransform.map(QPointF(path.elementAt(i - 1))));
+						mLinePoints.append(operationTransform.map(QPointF(path.elementAt(i))));
+					}
+				}
+			}
+			else if (type == LinesBatch)
+			{
+				for(auto pointIter = operation.points.begin(); pointIter != operation.points.end(); pointIter++)
+					mLinePoints.append(operationTransform.map(*pointIter));
+			}
+			else
+			{
+				mRects.append(rect);
+				mRectsBounds = (mRects.size() == 1) ? rect : mRectsBounds.united(rect);
+			}
+
+			mType = type;
+			mPen = state.pen;
+			mBrush = state.brush;
+			added = true;
+		}
+	}
+
+	return added;
+}
+
+void DrawingDisplayListBatch::draw(QPainter* painter, qreal minimumPenWidth)
+{
+	if (painter && mType != NoBatch)
+	{
+		QPen scenePen = painter->pen();
+		QBrush sceneBrush = painter->brush();
+
+		qreal scale = qSqrt(qAbs(painter->combinedTransform().determinant()));
+
+		// A zero-width pen is drawn one pixel wide regardless of the painter's transform
+		QPen pen = mPen;
+		if (pen.style() != Qt::NoPen && !pen.isCosmetic() && pen.widthF() * scale < minimumPenWidth)
+			pen.setWidthF(0);
+
+		painter->setPen(pen);
+
+		if (mType == LinesBatch)
+		{
+			painter->setBrush(Qt::NoBrush);
+			painter->drawLines(mLinePoints.constData(), mLinePoints.size() / 2);
+		}
+		else
+		{
+			painter->setBrush(mBrush);
+			painter->drawRects(mRects.constData(), mRects.size());
+		}
+
+		painter->setPen(scenePen);
+		painter->setBrush(sceneBrush);
+	}
+
+	clear();
+}
+
+void DrawingDisplayListBatch::clear()
+{
+	// Keep the allocated capacity, since the batch is usually refilled right away
+	mType = NoBatch;
+	mLinePoints.resize(0);
+	mRects.resize(0);
+	mRectsBounds = QRectF();
+}
+
+bool DrawingDisplayListBatch::isEmpty() const
+{
+	return (mType == NoBatch);
+}
+
+//==================================================================================================
+
+bool DrawingDisplayListBatch::overlapsRects(const QRectF& rect) const
+{
+	// QPainter::drawRects() fills all of the rects before stroking any of them, so where two
+	// filled rects overlap, the outline of the lower rect would be drawn over the fill of the
+	// higher one.  Rects that are not filled are only stroked, so their order does not matter.
+	const int maximumCheckedRects = 256;
+	bool overlaps = false;
+
+	if (mType == RectsBatch && mBrush.style() != Qt::NoBrush && mBrush.color().alpha() != 0)
+	{
+		// Include the half of each outline that lies outside of its rect, for both rects
+		qreal margin = (mPen.style() == Qt::NoPen || mPen.isCosmetic()) ? 0 : mPen.widthF();
+		QRectF paddedRect = rect.normalized().adjusted(-margin, -margin, margin, margin);
+
+		if (rectsTouch(paddedRect, mRectsBounds.normalized()))
+		{
+			// Rather than checking each new rect against a large batch, start a new batch
+			overlaps = (mRects.size() > maximumCheckedRects);
+
+			for(auto rectIter = mRects.begin(); !overlaps && rectIter != mRects.end(); rectIter++)
+				overlaps = rectsTouch(paddedRect, rectIter->normalized());
+		}
+	}
+
+	return overlaps;
+}
+
+bool DrawingDisplayListBatch::rectsTouch(const QRectF& rect1, const QRectF& rect2)
+{
+	return (rect1.left() <= rect2.right() && rect2.left() <= rect1.right() &&
+		rect1.top() <= rect2.bottom() && rect2.top() <= rect1.bottom());
+}
+
+//==================================================================================================
+
+bool DrawingDisplayListBatch::isOpaqueSolidPen(const QPen& pen)
+{
+	return (pen.style() == Qt::SolidLine && pen.brush().style() == Qt::SolidPattern &&
+		pen.color().alpha() == 255);
+}
+
+bool DrawingDisplayListBatch::isLineSegmentPath(const QPainterPath& path)
+{
+	// Each line must be its own subpath (a move followed by a single line), since connected lines
+	// would be drawn with joins instead of caps
+	bool lineSegments = (path.elementCount() > 0);
+
+	for(int i = 0; lineSegments && i < path.elementCount(); i++)
+	{
+		QPainterPath::Element element = path.elementAt(i);
+
+		if (element.isLineTo())
+			lineSegments = (i > 0 && path.elementAt(i - 1).isMoveTo());
+		else
+			lineSegments = element.isMoveTo();
+	}
+
+	return lineSegments;
+}
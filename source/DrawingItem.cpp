@@ -19,6 +19,8 @@
  */
 
 #include "DrawingItem.h"
+#include "DrawingScene.h"
+#include "DrawingView.h"
 #include "DrawingItemPoint.h"
 #include "DrawingItemStyle.h"
 
@@ -26,10 +28,26 @@ DrawingItem::DrawingItem()
 {
 	mScene = nullptr;
 
+	mSceneTransformValid = false;
+
+	mBoundingRectCacheValid = false;
+	mShapeCacheValid = false;
+	mSceneBoundingRectCacheValid = false;
+	mGeometryCacheStyleVersion = 0;
+
+	mHitShapeCacheBucket = 0;
+	mHitShapeCacheValid = false;
+
+	mDisplayListCache = nullptr;
+	mDisplayListValid = false;
+
 	mFlags = (CanMove | CanResize | CanRotate | CanFlip | CanSelect);
 	mStyle = new DrawingItemStyle();
+	mStyle->mItem = this;
 
 	mParent = nullptr;
+	mChildIndex = 0;
+	mGroup = nullptr;
 
 	mSelected = false;
 	mVisible = true;
@@ -42,9 +60,22 @@ DrawingItem::DrawingItem(const DrawingItem& item)
 	mPosition = item.mPosition;
 	mTransform = item.mTransform;
 	mTransformInverse = item.mTransformInverse;
+	mSceneTransformValid = false;
+
+	mBoundingRectCacheValid = false;
+	mShapeCacheValid = false;
+	mSceneBoundingRectCacheValid = false;
+	mGeometryCacheStyleVersion = 0;
+
+	mHitShapeCacheBucket = 0;
+	mHitShapeCacheValid = false;
+
+	mDisplayListCache = nullptr;
+	mDisplayListValid = false;
 
 	mFlags = item.mFlags;
 	mStyle = new DrawingItemStyle(*item.mStyle);
+	mStyle->mItem = this;
 
 	for(auto pointIter = item.mPoints.begin(); pointIter != item.mPoints.end(); pointIter++)
 		addPoint(new DrawingItemPoint(**pointIter));
@@ -52,6 +83,8 @@ DrawingItem::DrawingItem(const DrawingItem& item)
 	for(auto itemIter = item.mChildren.begin(); itemIter != item.mChildren.end(); itemIter++)
 		addChild((*itemIter)->copy());
 	mParent = nullptr;
+	mChildIndex = 0;
+	mGroup = nullptr;
 
 	mSelected = false;
 	mVisible = true;
@@ -62,6 +95,7 @@ DrawingItem::~DrawingItem()
 	clearPoints();
 	clearChildren();
 	delete mStyle;
+	delete mDisplayListCache;
 	mParent = nullptr;
 	mScene = nullptr;
 }
@@ -78,22 +112,26 @@ DrawingScene* DrawingItem::scene() const
 void DrawingItem::setPosition(const QPointF& pos)
 {
 	mPosition = pos;
+	invalidateSceneTransform();
 }
 
 void DrawingItem::setPosition(qreal x, qreal y)
 {
 	mPosition.setX(x);
 	mPosition.setY(y);
+	invalidateSceneTransform();
 }
 
 void DrawingItem::setX(qreal x)
 {
 	mPosition.setX(x);
+	invalidateSceneTransform();
 }
 
 void DrawingItem::setY(qreal y)
 {
 	mPosition.setY(y);
+	invalidateSceneTransform();
 }
 
 QPointF DrawingItem::position() const
@@ -119,6 +157,7 @@ void DrawingItem::setTransform(const QTransform& transform, bool combine)
 	else mTransform = transform;
 
 	mTransformInverse = mTransform.inverted();
+	invalidateSceneTransform();
 }
 
 QTransform DrawingItem::transform() const
@@ -131,6 +170,18 @@ QTransform DrawingItem::transformInverted() const
 	return mTransformInverse;
 }
 
+QTransform DrawingItem::sceneTransform() const
+{
+	if (!mSceneTransformValid) updateSceneTransform();
+	return mSceneTransform;
+}
+
+QTransform DrawingItem::sceneTransformInverted() const
+{
+	if (!mSceneTransformValid) updateSceneTransform();
+	return mSceneTransformInverse;
+}
+
 //==================================================================================================
 
 void DrawingItem::setFlags(Flags flags)
@@ -151,6 +202,8 @@ void DrawingItem::setStyle(DrawingItemStyle* style)
 	{
 		delete mStyle;
 		mStyle = style;
+		mStyle->mItem = this;
+		prepareGeometryChange();
 	}
 }
 
@@ -167,6 +220,7 @@ void DrawingItem::addPoint(DrawingItemPoint* itemPoint)
 	{
 		mPoints.append(itemPoint);
 		itemPoint->mItem = this;
+		prepareGeometryChange();
 	}
 }
 
@@ -176,6 +230,7 @@ void DrawingItem::insertPoint(int index, DrawingItemPoint* itemPoint)
 	{
 		mPoints.insert(index, itemPoint);
 		itemPoint->mItem = this;
+		prepareGeometryChange();
 	}
 }
 
@@ -185,6 +240,7 @@ void DrawingItem::removePoint(DrawingItemPoint* itemPoint)
 	{
 		mPoints.removeAll(itemPoint);
 		itemPoint->mItem = nullptr;
+		prepareGeometryChange();
 	}
 }
 
@@ -271,6 +327,8 @@ void DrawingItem::addChild(DrawingItem* item)
 	{
 		mChildren.append(item);
 		item->mParent = this;
+		item->mChildIndex = mChildren.size() - 1;
+		item->invalidateSceneTransform();
 	}
 }
 
@@ -278,8 +336,11 @@ void DrawingItem::insertChild(int index, DrawingItem* item)
 {
 	if (item && item->mParent == nullptr)
 	{
+		index = qBound(0, index, mChildren.size());
 		mChildren.insert(index, item);
 		item->mParent = this;
+		updateChildIndices(index);
+		item->invalidateSceneTransform();
 	}
 }
 
@@ -287,8 +348,16 @@ void DrawingItem::removeChild(DrawingItem* item)
 {
 	if (item && item->mParent == this)
 	{
-		mChildren.removeAll(item);
+		// Remove the child from the scene's spatial index while it can still find the scene
+		const DrawingItem* topLevelItem = this;
+		while (topLevelItem->mParent) topLevelItem = topLevelItem->mParent;
+		if (topLevelItem->mScene) topLevelItem->mScene->unindexItem(item);
+
+		mChildren.removeAt(item->mChildIndex);
+		updateChildIndices(item->mChildIndex);
 		item->mParent = nullptr;
+		item->mChildIndex = 0;
+		item->invalidateSceneTransform();
 	}
 }
 
@@ -319,12 +388,22 @@ DrawingItem* DrawingItem::parent() const
 
 void DrawingItem::setVisible(bool visible)
 {
-	mVisible = visible;
+	if (mVisible != visible)
+	{
+		mVisible = visible;
+		markSceneIndexDirty();
+	}
 }
 
 void DrawingItem::setSelected(bool selected)
 {
-	mSelected = selected;
+	if (mSelected != selected)
+	{
+		// Some items are drawn differently when they are selected
+		mSelected = selected;
+		mDisplayListValid = false;
+		markSceneIndexDirty();
+	}
 }
 
 bool DrawingItem::isVisible() const
@@ -391,42 +470,155 @@ QPainterPath DrawingItem::mapToParent(const QPainterPath& path) const
 
 QPointF DrawingItem::mapFromScene(const QPointF& point) const
 {
-	return (mParent) ? mapFromParent(mParent->mapFromScene(point)) : mapFromParent(point);
+	return sceneTransformInverted().map(point);
 }
 
 QPolygonF DrawingItem::mapFromScene(const QRectF& rect) const
 {
-	return (mParent) ? mapFromParent(mParent->mapFromScene(rect)) : mapFromParent(rect);
+	return sceneTransformInverted().map(QPolygonF(rect));
 }
 
 QPolygonF DrawingItem::mapFromScene(const QPolygonF& polygon) const
 {
-	return (mParent) ? mapFromParent(mParent->mapFromScene(polygon)) : mapFromParent(polygon);
+	return sceneTransformInverted().map(polygon);
 }
 
 QPainterPath DrawingItem::mapFromScene(const QPainterPath& path) const
 {
-	return (mParent) ? mapFromParent(mParent->mapFromScene(path)) : mapFromParent(path);
+	return sceneTransformInverted().map(path);
 }
 
 QPointF DrawingItem::mapToScene(const QPointF& point) const
 {
-	return (mParent) ? mParent->mapToScene(mapToParent(point)) : mapToParent(point);
+	return sceneTransform().map(point);
 }
 
 QPolygonF DrawingItem::mapToScene(const QRectF& rect) const
 {
-	return (mParent) ? mParent->mapToScene(mapToParent(rect)) : mapToParent(rect);
+	return sceneTransform().map(QPolygonF(rect));
 }
 
 QPolygonF DrawingItem::mapToScene(const QPolygonF& polygon) const
 {
-	return (mParent) ? mParent->mapToScene(mapToParent(polygon)) : mapToParent(polygon);
+	return sceneTransform().map(polygon);
 }
 
 QPainterPath DrawingItem::mapToScene(const QPainterPath& path) const
 {
-	return (mParent) ? mParent->mapToScene(mapToParent(path)) : mapToParent(path);
+	return sceneTransform().map(path);
+}
+
+//==================================================================================================
+
+QRectF DrawingItem::sceneBoundingRect() const
+{
+	checkGeometryCacheStyle();
+
+	if (!mSceneBoundingRectCacheValid)
+	{
+		mSceneBoundingRectCache = sceneTransform().mapRect(cachedBoundingRect());
+		mSceneBoundingRectCacheValid = true;
+	}
+
+	return mSceneBoundingRectCache;
+}
+
+QRectF DrawingItem::cachedBoundingRect() const
+{
+	checkGeometryCacheStyle();
+
+	if (!mBoundingRectCacheValid)
+	{
+		mBoundingRectCache = boundingRect();
+		mBoundingRectCacheValid = true;
+	}
+
+	return mBoundingRectCache;
+}
+
+QPainterPath DrawingItem::cachedShape() const
+{
+	checkGeometryCacheStyle();
+
+	if (!mShapeCacheValid)
+	{
+		mShapeCache = shape();
+		mShapeCacheValid = true;
+	}
+
+	return mShapeCache;
+}
+
+QPainterPath DrawingItem::cachedHitShape(qreal minimumPenWidth) const
+{
+	QPainterPath hitShape;
+	qreal penWidth = 0;
+
+	QVariant value = mStyle->valueLookup(DrawingItemStyle::PenWidth);
+	if (value.isValid()) penWidth = value.toDouble();
+
+	if (0 < penWidth && penWidth < minimumPenWidth)
+	{
+		// Round the minimum pen width up to the next half power of two so that the cached shape
+		// can be reused until the zoom level changes significantly
+		int bucket = qCeil(2 * qLn(minimumPenWidth) / M_LN2);
+
+		checkGeometryCacheStyle();
+
+		if (!mHitShapeCacheValid || mHitShapeCacheBucket != bucket)
+		{
+			qreal bucketPenWidth = qPow(2, bucket / 2.0);
+			QPainterPath shape = cachedShape();
+
+			// Widen the outline of the shape by the difference between the pen widths
+			QPainterPathStroker stroker;
+			stroker.setWidth(bucketPenWidth - penWidth);
+			stroker.setCapStyle(Qt::SquareCap);
+			stroker.setJoinStyle(Qt::BevelJoin);
+
+			mHitShapeCache = shape.united(stroker.createStroke(shape));
+			mHitShapeCacheBucket = bucket;
+			mHitShapeCacheValid = true;
+		}
+
+		hitShape = mHitShapeCache;
+	}
+	else hitShape = cachedShape();
+
+	return hitShape;
+}
+
+const DrawingDisplayList& DrawingItem::displayList()
+{
+	const DrawingItem* topLevelItem = this;
+	while (topLevelItem->mParent) topLevelItem = topLevelItem->mParent;
+
+	QBrush backgroundBrush = (topLevelItem->mScene) ? topLevelItem->mScene->backgroundBrush() : QBrush();
+
+	checkGeometryCacheStyle();
+
+	if (mDisplayListCache == nullptr)
+	{
+		mDisplayListCache = new DisplayListCache();
+		mDisplayListValid = false;
+	}
+
+	if (!mDisplayListValid || mDisplayListCache->backgroundBrush != backgroundBrush)
+	{
+		mDisplayListCache->displayList.clear();
+
+		// DrawingScene::drawBackground() leaves the painter's brush set to the background brush
+		// when the items are rendered, so record the item the same way
+		QPainter painter(&mDisplayListCache->displayList);
+		painter.setBrush(backgroundBrush);
+		render(&painter);
+		painter.end();
+
+		mDisplayListCache->backgroundBrush = backgroundBrush;
+		mDisplayListValid = true;
+	}
+
+	return mDisplayListCache->displayList;
 }
 
 //==================================================================================================
@@ -434,18 +626,18 @@ QPainterPath DrawingItem::mapToScene(const QPainterPath& path) const
 QPainterPath DrawingItem::shape() const
 {
 	QPainterPath path;
-	path.addRect(boundingRect());
+	path.addRect(cachedBoundingRect());
 	return path;
 }
 
 QPointF DrawingItem::centerPos() const
 {
-	return boundingRect().center();
+	return cachedBoundingRect().center();
 }
 
 bool DrawingItem::isValid() const
 {
-	return boundingRect().isValid();
+	return cachedBoundingRect().isValid();
 }
 
 //==================================================================================================
@@ -458,6 +650,7 @@ void DrawingItem::moveEvent(const QPointF& parentPos)
 		originalScenePos[*childIter] = (*childIter)->mapToScene((*childIter)->mapFromParent((*childIter)->position()));
 
 	mPosition = parentPos;
+	invalidateSceneTransform();
 
 	// Don't move children
 	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
@@ -497,6 +690,7 @@ void DrawingItem::rotateEvent(const QPointF& parentPos)
 	// Update orientation
 	mTransform.rotate(90);
 	mTransformInverse = mTransform.inverted();
+	invalidateSceneTransform();
 
 	// Don't apply rotation to children
 	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
@@ -513,6 +707,7 @@ void DrawingItem::rotateBackEvent(const QPointF& parentPos)
 	// Update orientation
 	mTransform.rotate(-90);
 	mTransformInverse = mTransform.inverted();
+	invalidateSceneTransform();
 
 	// Don't apply rotation to children
 	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
@@ -527,6 +722,7 @@ void DrawingItem::flipHorizontalEvent(const QPointF& parentPos)
 	// Update orientation
 	mTransform.scale(-1, 1);
 	mTransformInverse = mTransform.inverted();
+	invalidateSceneTransform();
 
 	// Don't apply flip to children
 	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
@@ -541,6 +737,7 @@ void DrawingItem::flipVerticalEvent(const QPointF& parentPos)
 	// Update orientation
 	mTransform.scale(1, -1);
 	mTransformInverse = mTransform.inverted();
+	invalidateSceneTransform();
 
 	// Don't apply flip to children
 	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
@@ -559,6 +756,17 @@ void DrawingItem::keyReleaseEvent(QKeyEvent* event)
 
 //==================================================================================================
 
+void DrawingItem::prepareGeometryChange()
+{
+	mBoundingRectCacheValid = false;
+	mShapeCacheValid = false;
+	mSceneBoundingRectCacheValid = false;
+	mHitShapeCacheValid = false;
+	mDisplayListValid = false;
+
+	markSceneIndexDirty();
+}
+
 QPainterPath DrawingItem::strokePath(const QPainterPath& path, const QPen& pen) const
 {
 	if (path == QPainterPath()) return path;
@@ -581,6 +789,43 @@ QPainterPath DrawingItem::strokePath(const QPainterPath& path, const QPen& pen)
 	return ps.createStroke(path);
 }
 
+QRectF DrawingItem::exposedRect(QPainter* painter) const
+{
+	return (painter && painter->hasClipping()) ? painter->clipBoundingRect() : QRectF();
+}
+
+qreal DrawingItem::renderScale(QPainter* painter) const
+{
+	return (painter) ? qSqrt(qAbs(painter->combinedTransform().determinant())) : 1.0;
+}
+
+bool DrawingItem::isTextVisible(QPainter* painter, const QFont& font) const
+{
+	const DrawingView* view = renderView(painter);
+	return (view == nullptr || font.pointSizeF() * renderScale(painter) >= view->minimumTextSize());
+}
+
+bool DrawingItem::isDetailVisible(QPainter* painter, qreal size) const
+{
+	const DrawingView* view = renderView(painter);
+	return (view == nullptr || size * renderScale(painter) >= view->minimumDetailSize());
+}
+
+QPen DrawingItem::renderPen(QPainter* painter, const QPen& pen) const
+{
+	QPen adjustedPen = pen;
+
+	const DrawingView* view = renderView(painter);
+	if (view && pen.style() != Qt::NoPen && !pen.isCosmetic() &&
+		pen.widthF() * renderScale(painter) < view->minimumRenderPenWidth())
+	{
+		// A zero-width pen is drawn one pixel wide regardless of the painter's transform
+		adjustedPen.setWidthF(0);
+	}
+
+	return adjustedPen;
+}
+
 //==================================================================================================
 
 QList<DrawingItem*> DrawingItem::copyItems(const QList<DrawingItem*>& items)
@@ -593,9 +838,14 @@ QList<DrawingItem*> DrawingItem::copyItems(const QList<DrawingItem*>& items)
 	DrawingItemPoint* copiedTargetPoint;
 	DrawingItemPoint* copiedPoint;
 
+	QHash<DrawingItem*,int> itemIndices;
+
 	// Copy items
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		itemIndices.insert(*itemIter, copiedItems.size());
 		copiedItems.append((*itemIter)->copy());
+	}
 
 	// Maintain connections to other items in this list
 	for(int itemIndex = 0; itemIndex < items.size(); itemIndex++)
@@ -607,12 +857,12 @@ QList<DrawingItem*> DrawingItem::copyItems(const QList<DrawingItem*>& items)
 			for(auto targetIter = targetPoints.begin(); targetIter != targetPoints.end(); targetIter++)
 			{
 				targetItem = (*targetIter)->item();
-				if (items.contains(targetItem))
+				if (itemIndices.contains(targetItem))
 				{
 					// There is a connection here that must be maintained in the copied items
 					copiedPoint = copiedItems[itemIndex]->points().at(pointIndex);
 
-					copiedTargetItem = copiedItems[items.indexOf(targetItem)];
+					copiedTargetItem = copiedItems[itemIndices.value(targetItem)];
 					copiedTargetPoint =
 						copiedTargetItem->points().at(targetItem->points().indexOf(*targetIter));
 
@@ -628,3 +878,115 @@ QList<DrawingItem*> DrawingItem::copyItems(const QList<DrawingItem*>& items)
 
 	return copiedItems;
 }
+
+//==================================================================================================
+
+void DrawingItem::invalidateSceneTransform()
+{
+	invalidateSceneTransformCache();
+	markSceneIndexDirty();
+}
+
+void DrawingItem::invalidateSceneTransformCache()
+{
+	// If this item's scene transform is already invalid, then so are those of its children
+	if (mSceneTransformValid)
+	{
+		mSceneTransformValid = false;
+		mSceneBoundingRectCacheValid = false;
+
+		for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
+			(*childIter)->invalidateSceneTransformCache();
+	}
+}
+
+void DrawingItem::updateSceneTransform() const
+{
+	// Equivalent to mapToParent(): apply the inverse transform, then translate by the position
+	QTransform parentTransform = mTransformInverse * QTransform::fromTranslate(mPosition.x(), mPosition.y());
+	QTransform parentTransformInverse = QTransform::fromTranslate(-mPosition.x(), -mPosition.y()) * mTransform;
+
+	if (mParent)
+	{
+		mSceneTransform = parentTransform * mParent->sceneTransform();
+		mSceneTransformInverse = mParent->sceneTransformInverted() * parentTransformInverse;
+	}
+	else
+	{
+		mSceneTransform = parentTransform;
+		mSceneTransformInverse = parentTransformInverse;
+	}
+
+	mSceneTransformValid = true;
+}
+
+//==================================================================================================
+
+void DrawingItem::checkGeometryCacheStyle() const
+{
+	quint64 styleVersion = mStyle->version();
+
+	if (styleVersion != mGeometryCacheStyleVersion)
+	{
+		mBoundingRectCacheValid = false;
+		mShapeCacheValid = false;
+		mSceneBoundingRectCacheValid = false;
+		mHitShapeCacheValid = false;
+		mDisplayListValid = false;
+		mGeometryCacheStyleVersion = styleVersion;
+	}
+}
+
+void DrawingItem::markSceneIndexDirty()
+{
+	const DrawingItem* topLevelItem = this;
+	while (topLevelItem->mParent) topLevelItem = topLevelItem->mParent;
+
+	if (topLevelItem->mScene) topLevelItem->mScene->mDirtyIndexItems.insert(this);
+}
+
+void DrawingItem::styleChanged()
+{
+	// The geometry caches and display list are also checked against the style's version, but
+	// the scene needs to know which items to re-index and repaint
+	markSceneIndexDirty();
+}
+
+void DrawingItem::updateChildIndices(int firstIndex)
+{
+	// Each child keeps its index in mChildren so that DrawingScene can sort items in paint order
+	// without searching the list
+	for(int childIndex = firstIndex; childIndex < mChildren.size(); childIndex++)
+		mChildren[childIndex]->mChildIndex = childIndex;
+}
+
+void DrawingItem::releaseDisplayList()
+{
+	delete mDisplayListCache;
+	mDisplayListCache = nullptr;
+	mDisplayListValid = false;
+
+	for(auto childIter = mChildren.begin(); childIter != mChildren.end(); childIter++)
+		(*childIter)->releaseDisplayList();
+}
+
+const DrawingView* DrawingItem::renderView(QPainter* painter) const
+{
+	const DrawingView* view = nullptr;
+	const DrawingItem* item = this;
+	bool recording = false;
+
+	// Walk up through parents and DrawingItemGroups to the item in the scene.  Items are recorded
+	// into their displayList() at full detail, including the items of a group being recorded.
+	while (item && !recording)
+	{
+		recording = (painter && item->mDisplayListCache &&
+			painter->device() == &item->mDisplayListCache->displayList);
+
+		if (!recording && item->mScene) view = item->mScene->mRenderView;
+
+		item = (item->mParent) ? item->mParent : item->mGroup;
+	}
+
+	return (recording) ? nullptr : view;
+}
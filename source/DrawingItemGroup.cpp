@@ -32,6 +32,8 @@ DrawingItemGroup::DrawingItemGroup() : DrawingItem()
 DrawingItemGroup::DrawingItemGroup(const DrawingItemGroup& item) : DrawingItem(item)
 {
 	mItems = copyItems(item.mItems);
+	for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
+		(*itemIter)->mGroup = this;
 	mItemsRect = item.mItemsRect;
 }
 
@@ -53,7 +55,10 @@ void DrawingItemGroup::setItems(const QList<DrawingItem*>& items)
 {
 	while (!mItems.isEmpty()) delete mItems.takeFirst();
 	mItems = items;
+	for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
+		(*itemIter)->mGroup = this;
 	recalculateContentsRect();
+	prepareGeometryChange();
 }
 
 QList<DrawingItem*> DrawingItemGroup::items() const
@@ -120,7 +125,7 @@ void DrawingItemGroup::recalculateContentsRect()
 	{
 		if ((*itemIter)->isVisible())
 		{
-			itemRect = (*itemIter)->mapToParent((*itemIter)->boundingRect()).boundingRect();
+			itemRect = (*itemIter)->mapToParent((*itemIter)->cachedBoundingRect()).boundingRect();
 
 			if (!mItemsRect.isValid()) mItemsRect = itemRect;
 			else mItemsRect = mItemsRect.united(itemRect);
@@ -52,22 +52,26 @@ DrawingItem* DrawingItemPoint::item() const
 void DrawingItemPoint::setPosition(const QPointF& pos)
 {
 	mPosition = pos;
+	if (mItem) mItem->prepareGeometryChange();
 }
 
 void DrawingItemPoint::setPosition(qreal x, qreal y)
 {
 	mPosition.setX(x);
 	mPosition.setY(y);
+	if (mItem) mItem->prepareGeometryChange();
 }
 
 void DrawingItemPoint::setX(qreal x)
 {
 	mPosition.setX(x);
+	if (mItem) mItem->prepareGeometryChange();
 }
 
 void DrawingItemPoint::setY(qreal y)
 {
 	mPosition.setY(y);
+	if (mItem) mItem->prepareGeometryChange();
 }
 
 QPointF DrawingItemPoint::position() const
@@ -19,166 +19,222 @@
  */
 
 #include "DrawingItemStyle.h"
+#include "DrawingItem.h"
+
+struct ArrowKey
+{
+	DrawingItemStyle::ArrowStyle style;
+	qreal size;
+	qreal direction;
+};
+
+struct ArrowGeometry
+{
+	QPolygonF points;
+	QPainterPath shape;
+};
+
+inline bool operator==(const ArrowKey& key1, const ArrowKey& key2)
+{
+	return (key1.style == key2.style && key1.size == key2.size && key1.direction == key2.direction);
+}
+
+inline uint qHash(const ArrowKey& key)
+{
+	return (qHash(key.size) ^ (31 * qHash(key.direction))) + (uint)key.style;
+}
+
+static QPolygonF createUnitArrowPoints(DrawingItemStyle::ArrowStyle style);
+static const ArrowGeometry* cachedArrowGeometry(DrawingItemStyle::ArrowStyle style, qreal size,
+	qreal direction);
+
+//==================================================================================================
 
 QHash<DrawingItemStyle::Property,QVariant> DrawingItemStyle::mDefaultProperties;
+quint64 DrawingItemStyle::mDefaultVersion = 0;
+quint64 DrawingItemStyle::mVersionCounter = 0;
+QMultiHash<uint,DrawingItemStyle::Data*> DrawingItemStyle::mInternedData;
+QHash<QString,DrawingItemStyle::StyleClass*> DrawingItemStyle::mStyleClasses;
+quint64 DrawingItemStyle::mClassVersion = 0;
 
-DrawingItemStyle::DrawingItemStyle() { }
+DrawingItemStyle::DrawingItemStyle()
+{
+	mItem = nullptr;
+	setData(Data());
+}
 
 DrawingItemStyle::DrawingItemStyle(const DrawingItemStyle& style)
 {
-	mProperties = style.mProperties;
+	mData = style.mData;
+	mVersion = style.mVersion;
+	mItem = nullptr;
 }
 
 DrawingItemStyle::~DrawingItemStyle() { }
 
+DrawingItemStyle& DrawingItemStyle::operator=(const DrawingItemStyle& style)
+{
+	mData = style.mData;
+	mVersion = ++mVersionCounter;
+	if (mItem) mItem->styleChanged();
+	return *this;
+}
+
 //==================================================================================================
 
 void DrawingItemStyle::setValues(const QHash<Property,QVariant>& values)
 {
-	mProperties = values;
+	Data data;
+
+	for(auto valueIter = values.begin(); valueIter != values.end(); valueIter++)
+		data.setValue(valueIter.key(), valueIter.value());
+
+	setData(data);
 }
 
 QHash<DrawingItemStyle::Property,QVariant> DrawingItemStyle::values() const
 {
-	return mProperties;
+	QHash<Property,QVariant> values;
+
+	for(int index = 0; index < NumberOfProperties; index++)
+	{
+		if (hasValue((Property)index)) values.insert((Property)index, value((Property)index));
+	}
+
+	return values;
 }
 
 //==================================================================================================
 
 void DrawingItemStyle::setValue(Property index, const QVariant& value)
 {
-	mProperties.insert(index, value);
+	Data data(*mData);
+	data.setValue(index, value);
+	setData(data);
 }
 
 void DrawingItemStyle::unsetValue(Property index)
 {
-	mProperties.remove(index);
+	Data data(*mData);
+	data.unsetValue(index);
+	setData(data);
 }
 
 void DrawingItemStyle::clearValues()
 {
-	mProperties.clear();
+	setData(Data());
 }
 
 bool DrawingItemStyle::hasValue(Property index) const
 {
-	return mProperties.contains(index);
+	return mData->hasValue(index);
 }
 
 QVariant DrawingItemStyle::value(Property index) const
 {
-	return mProperties.value(index, QVariant());
+	return mData->value(index);
 }
 
 //==================================================================================================
 
-QVariant DrawingItemStyle::valueLookup(Property index) const
+void DrawingItemStyle::setStyleClass(const QString& className)
 {
-	QVariant value;
+	Data data(*mData);
+	data.styleClass = findStyleClass(className, true);
+	setData(data);
+}
 
-	value = mDefaultProperties.value(index, value);
-	value = mProperties.value(index, value);
+QString DrawingItemStyle::styleClass() const
+{
+	return (mData->styleClass) ? mData->styleClass->name : QString();
+}
 
-	return value;
+//==================================================================================================
+
+QVariant DrawingItemStyle::valueLookup(Property index) const
+{
+	return valueLookup(index, QVariant());
 }
 
 QVariant DrawingItemStyle::valueLookup(Property index, const QVariant& fallbackValue) const
 {
-	QVariant value = fallbackValue;
+	return lookupValue(mData.data(), index, fallbackValue);
+}
 
-	value = mDefaultProperties.value(index, value);
-	value = mProperties.value(index, value);
+//==================================================================================================
 
-	return value;
+quint64 DrawingItemStyle::version() const
+{
+	// All versions are taken from the same counter, and this style takes a new version whenever
+	// its values are changed, so the largest one is always the most recent change to this style,
+	// its style class, or the defaults.  The version of the shared values alone is not enough:
+	// switching to an older record that was interned before the last change to the defaults would
+	// not change it.
+	return qMax(mVersion, dataVersion());
 }
 
 //==================================================================================================
 
 QPen DrawingItemStyle::pen() const
 {
-	Qt::PenStyle style = (Qt::PenStyle)valueLookup(PenStyle, QVariant((uint)Qt::SolidLine)).toUInt();
-	QColor color = valueLookup(PenColor, QVariant(QColor(0, 0, 0))).value<QColor>();
-	qreal opacity = valueLookup(PenOpacity, QVariant(1.0)).toReal();
-	qreal width = valueLookup(PenWidth, QVariant(1.0)).toReal();
-	Qt::PenCapStyle capStyle = (Qt::PenCapStyle)valueLookup(PenCapStyle, QVariant((uint)Qt::RoundCap)).toUInt();
-	Qt::PenJoinStyle joinStyle = (Qt::PenJoinStyle)valueLookup(PenJoinStyle, QVariant((uint)Qt::RoundJoin)).toUInt();
-
-	color.setAlphaF(opacity);
-
-	return QPen(QBrush(color), width, style, capStyle, joinStyle);
+	return resolvedValues().pen;
 }
 
 QBrush DrawingItemStyle::brush() const
 {
-	Qt::BrushStyle style = (Qt::BrushStyle)valueLookup(BrushStyle, QVariant((uint)Qt::SolidPattern)).toUInt();
-	QColor color = valueLookup(BrushColor, QVariant(QColor(255, 255, 255))).value<QColor>();
-	qreal opacity = valueLookup(BrushOpacity, QVariant(1.0)).toReal();
-
-	color.setAlphaF(opacity);
-
-	return QBrush(color, style);
+	return resolvedValues().brush;
 }
 
 QFont DrawingItemStyle::font() const
 {
-	QString name = valueLookup(FontName, QVariant("Arial")).toString();
-	qreal size = valueLookup(FontSize, QVariant(1.0)).toReal();
-	bool bold = valueLookup(FontBold, QVariant(false)).toBool();
-	bool italic = valueLookup(FontItalic, QVariant(false)).toBool();
-	bool underline = valueLookup(FontUnderline, QVariant(false)).toBool();
-	bool overline = valueLookup(FontOverline, QVariant(false)).toBool();
-	bool strikeThrough = valueLookup(FontStrikeThrough, QVariant(false)).toBool();
-
-	QFont font;
-	font.setFamily(name);
-	font.setPointSizeF(size);
-	font.setBold(bold);
-	font.setItalic(italic);
-	font.setUnderline(underline);
-	font.setOverline(overline);
-	font.setStrikeOut(strikeThrough);
-
-	return font;
+	return resolvedValues().font;
 }
 
 QBrush DrawingItemStyle::textBrush() const
 {
-	QColor color = valueLookup(TextColor, QVariant(QColor(0, 0, 0))).value<QColor>();
-	qreal opacity = valueLookup(TextOpacity, QVariant(1.0)).toReal();
-
-	color.setAlphaF(opacity);
-
-	return QBrush(color);
+	return resolvedValues().textBrush;
 }
 
 Qt::Alignment DrawingItemStyle::textAlignment() const
 {
-	Qt::Alignment horizontalAlignment =
-		(Qt::Alignment)valueLookup(TextHorizontalAlignment, QVariant((uint)Qt::AlignHCenter)).toUInt();
-	Qt::Alignment verticalAlignment =
-		(Qt::Alignment)valueLookup(TextVerticalAlignment, QVariant((uint)Qt::AlignVCenter)).toUInt();
-
-	return ((horizontalAlignment & Qt::AlignHorizontal_Mask) | (verticalAlignment & Qt::AlignVertical_Mask));
+	return resolvedValues().textAlignment;
 }
 
 DrawingItemStyle::ArrowStyle DrawingItemStyle::startArrowStyle() const
 {
-	return (ArrowStyle)valueLookup(StartArrowStyle, QVariant((uint)ArrowNone)).toUInt();
+	return resolvedValues().startArrowStyle;
 }
 
 qreal DrawingItemStyle::startArrowSize() const
 {
-	return valueLookup(StartArrowSize, QVariant(0.0)).toReal();
+	return resolvedValues().startArrowSize;
 }
 
 DrawingItemStyle::ArrowStyle DrawingItemStyle::endArrowStyle() const
 {
-	return (ArrowStyle)valueLookup(EndArrowStyle, QVariant((uint)ArrowNone)).toUInt();
+	return resolvedValues().endArrowStyle;
 }
 
 qreal DrawingItemStyle::endArrowSize() const
 {
-	return valueLookup(EndArrowSize, QVariant(0.0)).toReal();
+	return resolvedValues().endArrowSize;
+}
+
+//==================================================================================================
+
+const DrawingItemStyle::ResolvedValues& DrawingItemStyle::resolvedValues() const
+{
+	// The resolved values are stored with the shared values, and are updated whenever the shared
+	// values, the style class, or the defaults change.  Items may be rendered from several threads
+	// at once, so they are only read here.
+	return mData->resolved;
+}
+
+quint64 DrawingItemStyle::dataVersion() const
+{
+	quint64 version = qMax(mData->version, mDefaultVersion);
+	if (mData->styleClass) version = qMax(version, mData->styleClass->version);
+	return version;
 }
 
 //==================================================================================================
@@ -249,122 +305,318 @@ QPainterPath DrawingItemStyle::arrowShape(ArrowStyle style, qreal size, const QP
 	qreal direction) const
 {
 	QPainterPath path;
-	QPolygonF polygon;
 
-	if (style != ArrowNone)
+	if (style == ArrowCircle || style == ArrowCircleFilled)
+		path.addEllipse(pos, size / 2, size / 2);
+	else if (style != ArrowNone)
+		path = cachedArrowGeometry(style, size, direction)->shape.translated(pos);
+
+	return path;
+}
+
+QVariant DrawingItemStyle::lookupValue(const Data* data, Property index, const QVariant& fallbackValue)
+{
+	QVariant value;
+
+	if (data->hasValue(index))
+		value = data->value(index);
+	else if (data->styleClass && data->styleClass->values.hasValue(index))
+		value = data->styleClass->values.value(index);
+	else
+		value = mDefaultProperties.value(index, fallbackValue);
+
+	return value;
+}
+
+void DrawingItemStyle::setData(const Data& data)
+{
+	uint hash = data.valueHash();
+	Data* sharedData = nullptr;
+
+	for(auto dataIter = mInternedData.find(hash);
+		sharedData == nullptr && dataIter != mInternedData.end() && dataIter.key() == hash; dataIter++)
 	{
-		switch (style)
-		{
-		case ArrowCircle:
-		case ArrowCircleFilled:
-			path.addEllipse(pos, size / 2, size / 2);
-			break;
-		case ArrowHarpoon:
-		case ArrowHarpoonMirrored:
-			polygon = calculateArrowPoints(style, size, pos, direction);
-			path.moveTo(polygon[0]);
-			path.lineTo(polygon[1]);
-			break;
-		case ArrowX:
-			polygon = calculateArrowPoints(style, size, pos, direction);
-			path.moveTo(polygon[0]);
-			path.lineTo(polygon[1]);
-			path.moveTo(polygon[2]);
-			path.lineTo(polygon[3]);
-			break;
-		default:
-			polygon = calculateArrowPoints(style, size, pos, direction);
-			path.moveTo(polygon[0]);
-			path.addPolygon(polygon);
-			path.closeSubpath();
-			break;
-		}
+		if ((*dataIter)->hasSameValues(data)) sharedData = *dataIter;
 	}
 
-	return path;
+	if (sharedData == nullptr)
+	{
+		sharedData = new Data(data);
+		sharedData->version = ++mVersionCounter;
+		sharedData->hash = hash;
+		sharedData->interned = true;
+		mInternedData.insert(hash, sharedData);
+		resolveValues(sharedData);
+	}
+
+	mData = sharedData;
+	mVersion = ++mVersionCounter;
+
+	// Let the item that uses this style know that it needs to be re-indexed and repainted
+	if (mItem) mItem->styleChanged();
 }
 
-QPolygonF DrawingItemStyle::calculateArrowPoints(ArrowStyle style, qreal size,
-	const QPointF& pos, qreal direction) const
+void DrawingItemStyle::resolveValues(Data* data)
 {
-	QPolygonF polygon;
-	const qreal sqrt2 = qSqrt(2);
-	qreal angle = 0;
+	// Pen
+	Qt::PenStyle penStyle = (Qt::PenStyle)lookupValue(data, PenStyle, QVariant((uint)Qt::SolidLine)).toUInt();
+	QColor penColor = lookupValue(data, PenColor, QVariant(QColor(0, 0, 0))).value<QColor>();
+	qreal penOpacity = lookupValue(data, PenOpacity, QVariant(1.0)).toReal();
+	qreal penWidth = lookupValue(data, PenWidth, QVariant(1.0)).toReal();
+	Qt::PenCapStyle penCapStyle = (Qt::PenCapStyle)lookupValue(data, PenCapStyle, QVariant((uint)Qt::RoundCap)).toUInt();
+	Qt::PenJoinStyle penJoinStyle = (Qt::PenJoinStyle)lookupValue(data, PenJoinStyle, QVariant((uint)Qt::RoundJoin)).toUInt();
+
+	penColor.setAlphaF(penOpacity);
+	data->resolved.pen = QPen(QBrush(penColor), penWidth, penStyle, penCapStyle, penJoinStyle);
+
+	// Brush
+	Qt::BrushStyle brushStyle = (Qt::BrushStyle)lookupValue(data, BrushStyle, QVariant((uint)Qt::SolidPattern)).toUInt();
+	QColor brushColor = lookupValue(data, BrushColor, QVariant(QColor(255, 255, 255))).value<QColor>();
+	qreal brushOpacity = lookupValue(data, BrushOpacity, QVariant(1.0)).toReal();
+
+	brushColor.setAlphaF(brushOpacity);
+	data->resolved.brush = QBrush(brushColor, brushStyle);
+
+	// Font
+	data->resolved.font = QFont();
+	data->resolved.font.setFamily(lookupValue(data, FontName, QVariant("Arial")).toString());
+	data->resolved.font.setPointSizeF(lookupValue(data, FontSize, QVariant(1.0)).toReal());
+	data->resolved.font.setBold(lookupValue(data, FontBold, QVariant(false)).toBool());
+	data->resolved.font.setItalic(lookupValue(data, FontItalic, QVariant(false)).toBool());
+	data->resolved.font.setUnderline(lookupValue(data, FontUnderline, QVariant(false)).toBool());
+	data->resolved.font.setOverline(lookupValue(data, FontOverline, QVariant(false)).toBool());
+	data->resolved.font.setStrikeOut(lookupValue(data, FontStrikeThrough, QVariant(false)).toBool());
+
+	// Text
+	QColor textColor = lookupValue(data, TextColor, QVariant(QColor(0, 0, 0))).value<QColor>();
+	qreal textOpacity = lookupValue(data, TextOpacity, QVariant(1.0)).toReal();
+
+	textColor.setAlphaF(textOpacity);
+	data->resolved.textBrush = QBrush(textColor);
+
+	Qt::Alignment horizontalAlignment =
+		(Qt::Alignment)lookupValue(data, TextHorizontalAlignment, QVariant((uint)Qt::AlignHCenter)).toUInt();
+	Qt::Alignment verticalAlignment =
+		(Qt::Alignment)lookupValue(data, TextVerticalAlignment, QVariant((uint)Qt::AlignVCenter)).toUInt();
 
-	direction = direction * 3.141592654 / 180;
+	data->resolved.textAlignment = ((horizontalAlignment & Qt::AlignHorizontal_Mask) |
+		(verticalAlignment & Qt::AlignVertical_Mask));
 
-	switch (style)
+	// Arrows
+	data->resolved.startArrowStyle = (ArrowStyle)lookupValue(data, StartArrowStyle, QVariant((uint)ArrowNone)).toUInt();
+	data->resolved.startArrowSize = lookupValue(data, StartArrowSize, QVariant(0.0)).toReal();
+	data->resolved.endArrowStyle = (ArrowStyle)lookupValue(data, EndArrowStyle, QVariant((uint)ArrowNone)).toUInt();
+	data->resolved.endArrowSize = lookupValue(data, EndArrowSize, QVariant(0.0)).toReal();
+}
+
+void DrawingItemStyle::resolveInternedData(const StyleClass* styleClass)
+{
+	// Only the records that use the style class are affected by a change to it; a change to the
+	// defaults (styleClass is null) affects all of them
+	for(auto dataIter = mInternedData.begin(); dataIter != mInternedData.end(); dataIter++)
 	{
-	case ArrowNormal:
-	case ArrowTriangle:
-	case ArrowTriangleFilled:
-		angle = 3.141592654 / 6;
-		polygon.append(pos);
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction - angle),
-							   pos.y() + size / sqrt2 * qSin(direction - angle)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + angle),
-							   pos.y() + size / sqrt2 * qSin(direction + angle)));
-		break;
-	case ArrowDiamond:
-	case ArrowDiamondFilled:
-		angle = 3.141592654;
-		polygon.append(QPointF(pos.x() + size / 2 * qCos(direction),
-							   pos.y() + size / 2 * qSin(direction)));
-		polygon.append(QPointF(pos.x() + size / 2 * qCos(direction - angle / 2),
-							   pos.y() + size / 2 * qSin(direction - angle / 2)));
-		polygon.append(QPointF(pos.x() + size / 2 * qCos(direction - angle),
-							   pos.y() + size / 2 * qSin(direction - angle)));
-		polygon.append(QPointF(pos.x() + size / 2 * qCos(direction + angle / 2),
-							   pos.y() + size / 2 * qSin(direction + angle / 2)));
-		break;
-	case ArrowHarpoon:
-		angle = 3.141592654 / 6;
-		polygon.append(pos);
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction - angle),
-							   pos.y() + size / sqrt2 * qSin(direction - angle)));
+		if (styleClass == nullptr || (*dataIter)->styleClass == styleClass)
+			resolveValues(*dataIter);
+	}
+}
+
+DrawingItemStyle::PropertyType DrawingItemStyle::propertyType(Property index)
+{
+	PropertyType type = UIntType;
+
+	switch (index)
+	{
+	case PenColor:
+	case BrushColor:
+	case TextColor:
+		type = ColorType;
 		break;
-	case ArrowHarpoonMirrored:
-		angle = 3.141592654 / 6;
-		polygon.append(pos);
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + angle),
-							   pos.y() + size / sqrt2 * qSin(direction + angle)));
+	case PenOpacity:
+	case PenWidth:
+	case BrushOpacity:
+	case FontSize:
+	case TextOpacity:
+	case StartArrowSize:
+	case EndArrowSize:
+		type = RealType;
 		break;
-	case ArrowConcave:
-	case ArrowConcaveFilled:
-		angle = 3.141592654 / 6;
-		polygon.append(pos);
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction - angle),
-							   pos.y() + size / sqrt2 * qSin(direction - angle)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 / 2 * qCos(direction),
-							   pos.y() + size / sqrt2 / 2 * qSin(direction)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + angle),
-							   pos.y() + size / sqrt2 * qSin(direction + angle)));
+	case FontBold:
+	case FontItalic:
+	case FontUnderline:
+	case FontOverline:
+	case FontStrikeThrough:
+		type = BoolType;
 		break;
-	case ArrowReverse:
-		angle = 3.141592654 / 6;
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction),
-							   pos.y() + size / sqrt2 * qSin(direction)));
-		polygon.append(QPointF(polygon[0].x() - size / sqrt2 * qCos(direction - angle),
-							   polygon[0].y() - size / sqrt2 * qSin(direction - angle)));
-		polygon.append(QPointF(polygon[0].x() - size / sqrt2 * qCos(direction + angle),
-							   polygon[0].y() - size / sqrt2 * qSin(direction + angle)));
-		break;
-	case ArrowX:
-		angle = 3.141592654 / 4;
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + angle),
-							   pos.y() + size / sqrt2 * qSin(direction + angle)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + 5 * angle),
-							   pos.y() + size / sqrt2 * qSin(direction + 5 * angle)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + 3 * angle),
-							   pos.y() + size / sqrt2 * qSin(direction + 3 * angle)));
-		polygon.append(QPointF(pos.x() + size / sqrt2 * qCos(direction + 7 * angle),
-							   pos.y() + size / sqrt2 * qSin(direction + 7 * angle)));
+	case FontName:
+		type = StringType;
 		break;
 	default:
 		break;
 	}
 
-	return polygon;
+	return type;
+}
+
+//==================================================================================================
+
+DrawingItemStyle::Data::Data()
+{
+	propertyMask = 0;
+	styleClass = nullptr;
+	version = 0;
+	hash = 0;
+	interned = false;
+}
+
+DrawingItemStyle::Data::Data(const Data& data) : QSharedData(data)
+{
+	propertyMask = data.propertyMask;
+	propertyValues = data.propertyValues;
+	fontName = data.fontName;
+	styleClass = data.styleClass;
+	version = 0;
+	hash = 0;
+	interned = false;
+}
+
+DrawingItemStyle::Data::~Data()
+{
+	if (interned) mInternedData.remove(hash, this);
+}
+
+//==================================================================================================
+
+void DrawingItemStyle::Data::setValue(Property index, const QVariant& value)
+{
+	if (0 <= index && index < NumberOfProperties)
+	{
+		if (value.isValid())
+		{
+			PropertyValue propertyValue;
+			propertyValue.colorValue = 0;
+
+			switch (propertyType(index))
+			{
+			case UIntType:
+				propertyValue.uintValue = value.toUInt();
+				break;
+			case RealType:
+				propertyValue.realValue = value.toReal();
+				break;
+			case BoolType:
+				propertyValue.boolValue = value.toBool();
+				break;
+			case ColorType:
+				propertyValue.colorValue = value.value<QColor>().rgba64();
+				break;
+			default:	// StringType
+				fontName = value.toString();
+				break;
+			}
+
+			// Values are kept in order of property index, so insert a new slot if needed
+			int slot = propertySlot(index);
+			if (hasValue(index)) propertyValues[slot] = propertyValue;
+			else
+			{
+				propertyValues.insert(slot, propertyValue);
+				propertyMask |= (1u << index);
+			}
+		}
+		else unsetValue(index);
+	}
+}
+
+void DrawingItemStyle::Data::unsetValue(Property index)
+{
+	if (hasValue(index))
+	{
+		propertyValues.remove(propertySlot(index));
+		propertyMask &= ~(1u << index);
+		if (propertyType(index) == StringType) fontName.clear();
+	}
+}
+
+void DrawingItemStyle::Data::clearValues()
+{
+	propertyMask = 0;
+	propertyValues.clear();
+	fontName.clear();
+}
+
+bool DrawingItemStyle::Data::hasValue(Property index) const
+{
+	return (0 <= index && index < NumberOfProperties && (propertyMask & (1u << index)));
+}
+
+QVariant DrawingItemStyle::Data::value(Property index) const
+{
+	QVariant value;
+
+	if (hasValue(index))
+	{
+		const PropertyValue& propertyValue = propertyValues[propertySlot(index)];
+
+		switch (propertyType(index))
+		{
+		case UIntType:
+			value = QVariant(propertyValue.uintValue);
+			break;
+		case RealType:
+			value = QVariant(propertyValue.realValue);
+			break;
+		case BoolType:
+			value = QVariant(propertyValue.boolValue);
+			break;
+		case ColorType:
+			value = QVariant(QColor::fromRgba64(QRgba64::fromRgba64(propertyValue.colorValue)));
+			break;
+		default:	// StringType
+			value = QVariant(fontName);
+			break;
+		}
+	}
+
+	return value;
+}
+
+//==================================================================================================
+
+int DrawingItemStyle::Data::propertySlot(Property index) const
+{
+	// The slot of a property is the number of properties with a lower index that are set
+	return qPopulationCount(propertyMask & ((1u << index) - 1));
+}
+
+uint DrawingItemStyle::Data::valueHash() const
+{
+	uint hash = qHash(propertyMask) ^ qHash(fontName) ^ qHash(styleClass);
+
+	for(auto valueIter = propertyValues.begin(); valueIter != propertyValues.end(); valueIter++)
+		hash = 31 * hash + qHash(valueIter->colorValue);
+
+	return hash;
+}
+
+bool DrawingItemStyle::Data::hasSameValues(const Data& data) const
+{
+	// Unused bytes of each value are always zero, so the values can be compared as 64-bit
+	// integers regardless of their type
+	bool same = (propertyMask == data.propertyMask && fontName == data.fontName &&
+		styleClass == data.styleClass);
+
+	for(int slot = 0; same && slot < propertyValues.size(); slot++)
+		same = (propertyValues[slot].colorValue == data.propertyValues[slot].colorValue);
+
+	return same;
+}
+
+//==================================================================================================
+
+QPolygonF DrawingItemStyle::calculateArrowPoints(ArrowStyle style, qreal size,
+	const QPointF& pos, qreal direction) const
+{
+	return cachedArrowGeometry(style, size, direction)->points.translated(pos);
 }
 
 //==================================================================================================
@@ -372,6 +624,8 @@ QPolygonF DrawingItemStyle::calculateArrowPoints(ArrowStyle style, qreal size,
 void DrawingItemStyle::setDefaultValues(const QHash<Property,QVariant>& values)
 {
 	mDefaultProperties = values;
+	mDefaultVersion = ++mVersionCounter;
+	resolveInternedData(nullptr);
 }
 
 QHash<DrawingItemStyle::Property,QVariant> DrawingItemStyle::defaultValues()
@@ -384,16 +638,22 @@ QHash<DrawingItemStyle::Property,QVariant> DrawingItemStyle::defaultValues()
 void DrawingItemStyle::setDefaultValue(Property index, const QVariant& value)
 {
 	mDefaultProperties.insert(index, value);
+	mDefaultVersion = ++mVersionCounter;
+	resolveInternedData(nullptr);
 }
 
 void DrawingItemStyle::unsetDefaultValue(Property index)
 {
 	mDefaultProperties.remove(index);
+	mDefaultVersion = ++mVersionCounter;
+	resolveInternedData(nullptr);
 }
 
 void DrawingItemStyle::clearDefaultValues()
 {
 	mDefaultProperties.clear();
+	mDefaultVersion = ++mVersionCounter;
+	resolveInternedData(nullptr);
 }
 
 bool DrawingItemStyle::hasDefaultValue(Property index)
@@ -405,3 +665,256 @@ QVariant DrawingItemStyle::defaultValue(Property index)
 {
 	return mDefaultProperties.value(index, QVariant());
 }
+
+//==================================================================================================
+
+void DrawingItemStyle::setClassValues(const QString& className, const QHash<Property,QVariant>& values)
+{
+	StyleClass* styleClass = findStyleClass(className, true);
+
+	if (styleClass)
+	{
+		styleClass->values.clearValues();
+		for(auto valueIter = values.begin(); valueIter != values.end(); valueIter++)
+			styleClass->values.setValue(valueIter.key(), valueIter.value());
+
+		styleClass->version = ++mVersionCounter;
+		mClassVersion = styleClass->version;
+		resolveInternedData(styleClass);
+	}
+}
+
+QHash<DrawingItemStyle::Property,QVariant> DrawingItemStyle::classValues(const QString& className)
+{
+	QHash<Property,QVariant> values;
+
+	StyleClass* styleClass = findStyleClass(className, false);
+	if (styleClass)
+	{
+		for(int index = 0; index < NumberOfProperties; index++)
+		{
+			if (styleClass->values.hasValue((Property)index))
+				values.insert((Property)index, styleClass->values.value((Property)index));
+		}
+	}
+
+	return values;
+}
+
+//==================================================================================================
+
+void DrawingItemStyle::setClassValue(const QString& className, Property index, const QVariant& value)
+{
+	StyleClass* styleClass = findStyleClass(className, true);
+
+	if (styleClass)
+	{
+		styleClass->values.setValue(index, value);
+		styleClass->version = ++mVersionCounter;
+		mClassVersion = styleClass->version;
+		resolveInternedData(styleClass);
+	}
+}
+
+void DrawingItemStyle::unsetClassValue(const QString& className, Property index)
+{
+	StyleClass* styleClass = findStyleClass(className, false);
+
+	if (styleClass)
+	{
+		styleClass->values.unsetValue(index);
+		styleClass->version = ++mVersionCounter;
+		mClassVersion = styleClass->version;
+		resolveInternedData(styleClass);
+	}
+}
+
+void DrawingItemStyle::clearClassValues(const QString& className)
+{
+	StyleClass* styleClass = findStyleClass(className, false);
+
+	if (styleClass)
+	{
+		styleClass->values.clearValues();
+		styleClass->version = ++mVersionCounter;
+		mClassVersion = styleClass->version;
+		resolveInternedData(styleClass);
+	}
+}
+
+bool DrawingItemStyle::hasClassValue(const QString& className, Property index)
+{
+	StyleClass* styleClass = findStyleClass(className, false);
+	return (styleClass && styleClass->values.hasValue(index));
+}
+
+QVariant DrawingItemStyle::classValue(const QString& className, Property index)
+{
+	StyleClass* styleClass = findStyleClass(className, false);
+	return (styleClass) ? styleClass->values.value(index) : QVariant();
+}
+
+QStringList DrawingItemStyle::classNames()
+{
+	return mStyleClasses.keys();
+}
+
+//==================================================================================================
+
+quint64 DrawingItemStyle::sharedVersion()
+{
+	return qMax(mDefaultVersion, mClassVersion);
+}
+
+quint64 DrawingItemStyle::defaultVersion()
+{
+	return mDefaultVersion;
+}
+
+quint64 DrawingItemStyle::classVersion(const QString& className)
+{
+	StyleClass* styleClass = findStyleClass(className, false);
+	return (styleClass) ? styleClass->version : 0;
+}
+
+//==================================================================================================
+
+DrawingItemStyle::StyleClass* DrawingItemStyle::findStyleClass(const QString& className, bool create)
+{
+	StyleClass* styleClass = mStyleClasses.value(className, nullptr);
+
+	// Style classes are never deleted, so styles can safely keep pointers to them
+	if (styleClass == nullptr && create && !className.isEmpty())
+	{
+		styleClass = new StyleClass();
+		styleClass->name = className;
+		styleClass->version = ++mVersionCounter;
+		mStyleClasses.insert(className, styleClass);
+	}
+
+	return styleClass;
+}
+
+//==================================================================================================
+
+QPolygonF createUnitArrowPoints(DrawingItemStyle::ArrowStyle style)
+{
+	// Points of an arrow of size 1.0 at the origin, pointing in the direction of the positive x-axis
+	QPolygonF polygon;
+	const qreal length = 1 / qSqrt(2);
+	qreal angle = 0;
+
+	switch (style)
+	{
+	case DrawingItemStyle::ArrowNormal:
+	case DrawingItemStyle::ArrowTriangle:
+	case DrawingItemStyle::ArrowTriangleFilled:
+		angle = 3.141592654 / 6;
+		polygon.append(QPointF(0, 0));
+		polygon.append(QPointF(length * qCos(-angle), length * qSin(-angle)));
+		polygon.append(QPointF(length * qCos(angle), length * qSin(angle)));
+		break;
+	case DrawingItemStyle::ArrowDiamond:
+	case DrawingItemStyle::ArrowDiamondFilled:
+		polygon.append(QPointF(0.5, 0));
+		polygon.append(QPointF(0, -0.5));
+		polygon.append(QPointF(-0.5, 0));
+		polygon.append(QPointF(0, 0.5));
+		break;
+	case DrawingItemStyle::ArrowHarpoon:
+		angle = 3.141592654 / 6;
+		polygon.append(QPointF(0, 0));
+		polygon.append(QPointF(length * qCos(-angle), length * qSin(-angle)));
+		break;
+	case DrawingItemStyle::ArrowHarpoonMirrored:
+		angle = 3.141592654 / 6;
+		polygon.append(QPointF(0, 0));
+		polygon.append(QPointF(length * qCos(angle), length * qSin(angle)));
+		break;
+	case DrawingItemStyle::ArrowConcave:
+	case DrawingItemStyle::ArrowConcaveFilled:
+		angle = 3.141592654 / 6;
+		polygon.append(QPointF(0, 0));
+		polygon.append(QPointF(length * qCos(-angle), length * qSin(-angle)));
+		polygon.append(QPointF(length / 2, 0));
+		polygon.append(QPointF(length * qCos(angle), length * qSin(angle)));
+		break;
+	case DrawingItemStyle::ArrowReverse:
+		angle = 3.141592654 / 6;
+		polygon.append(QPointF(length, 0));
+		polygon.append(QPointF(length - length * qCos(-angle), -length * qSin(-angle)));
+		polygon.append(QPointF(length - length * qCos(angle), -length * qSin(angle)));
+		break;
+	case DrawingItemStyle::ArrowX:
+		angle = 3.141592654 / 4;
+		polygon.append(QPointF(length * qCos(angle), length * qSin(angle)));
+		polygon.append(QPointF(length * qCos(5 * angle), length * qSin(5 * angle)));
+		polygon.append(QPointF(length * qCos(3 * angle), length * qSin(3 * angle)));
+		polygon.append(QPointF(length * qCos(7 * angle), length * qSin(7 * angle)));
+		break;
+	default:
+		break;
+	}
+
+	return polygon;
+}
+
+const ArrowGeometry* cachedArrowGeometry(DrawingItemStyle::ArrowStyle style, qreal size,
+	qreal direction)
+{
+	// Items are rendered from several threads at once, so each thread has its own cache
+	static const int maximumCachedArrows = 4096;
+	static QThreadStorage<QCache<ArrowKey,ArrowGeometry>*> arrowCaches;
+
+	static const QVector<QPolygonF> unitArrowPoints = []() {
+		QVector<QPolygonF> points;
+		for(int style = DrawingItemStyle::ArrowNone; style <= DrawingItemStyle::ArrowX; style++)
+			points.append(createUnitArrowPoints((DrawingItemStyle::ArrowStyle)style));
+		return points;
+	}();
+
+	if (!arrowCaches.hasLocalData())
+		arrowCaches.setLocalData(new QCache<ArrowKey,ArrowGeometry>(maximumCachedArrows));
+
+	QCache<ArrowKey,ArrowGeometry>* arrowCache = arrowCaches.localData();
+	ArrowKey key = { style, size, direction };
+
+	ArrowGeometry* geometry = arrowCache->object(key);
+	if (geometry == nullptr)
+	{
+		QTransform transform;
+		transform.rotate(direction);
+		transform.scale(size, size);
+
+		geometry = new ArrowGeometry();
+		geometry->points = transform.map(unitArrowPoints.value(style));
+
+		const QPolygonF& points = geometry->points;
+		switch (style)
+		{
+		case DrawingItemStyle::ArrowHarpoon:
+		case DrawingItemStyle::ArrowHarpoonMirrored:
+			geometry->shape.moveTo(points[0]);
+			geometry->shape.lineTo(points[1]);
+			break;
+		case DrawingItemStyle::ArrowX:
+			geometry->shape.moveTo(points[0]);
+			geometry->shape.lineTo(points[1]);
+			geometry->shape.moveTo(points[2]);
+			geometry->shape.lineTo(points[3]);
+			break;
+		default:
+			if (!points.isEmpty())
+			{
+				geometry->shape.moveTo(points[0]);
+				geometry->shape.addPolygon(points);
+				geometry->shape.closeSubpath();
+			}
+			break;
+		}
+
+		arrowCache->insert(key, geometry);
+	}
+
+	return geometry;
+}
@@ -176,7 +176,7 @@ void DrawingLineItem::render(QPainter* painter)
 		qreal lineAngle = 180 * qAtan2(p2.y() - p1.y(), p2.x() - p1.x()) / 3.141592654;
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		DrawingItemStyle::ArrowStyle startArrowStyle = style->startArrowStyle();
 		DrawingItemStyle::ArrowStyle endArrowStyle = style->endArrowStyle();
 		qreal startArrowSize = style->startArrowSize();
@@ -190,9 +190,9 @@ void DrawingLineItem::render(QPainter* painter)
 		// Draw arrows
 		if (pen.style() != Qt::NoPen)
 		{
-			if (lineLength > startArrowSize)
+			if (lineLength > startArrowSize && isDetailVisible(painter, startArrowSize))
 				style->drawArrow(painter, startArrowStyle, startArrowSize, p1, lineAngle, pen, sceneBrush);
-			if (lineLength > endArrowSize)
+			if (lineLength > endArrowSize && isDetailVisible(painter, endArrowSize))
 				style->drawArrow(painter, endArrowStyle, endArrowSize, p2, 180 + lineAngle, pen, sceneBrush);
 		}
 
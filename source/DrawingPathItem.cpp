@@ -117,6 +117,7 @@ void DrawingPathItem::setPath(const QPainterPath& path, const QRectF& pathRect)
 {
 	mPath = path;
 	mPathRect = pathRect;
+	prepareGeometryChange();
 }
 
 QPainterPath DrawingPathItem::path() const
@@ -260,7 +261,7 @@ void DrawingPathItem::render(QPainter* painter)
 		QPen scenePen = painter->pen();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 
 		// Draw path
@@ -161,7 +161,7 @@ void DrawingPolygonItem::render(QPainter* painter)
 		QPen scenePen = painter->pen();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 
 		// Draw polygon
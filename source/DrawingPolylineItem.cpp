@@ -197,7 +197,7 @@ void DrawingPolylineItem::render(QPainter* painter)
 		qreal lastLineAngle = 180 * qAtan2(p3.y() - p2.y(), p3.x() - p2.x()) / 3.141592654;
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		DrawingItemStyle::ArrowStyle startArrowStyle = style->startArrowStyle();
 		DrawingItemStyle::ArrowStyle endArrowStyle = style->endArrowStyle();
 		qreal startArrowSize = style->startArrowSize();
@@ -219,9 +219,9 @@ void DrawingPolylineItem::render(QPainter* painter)
 		// Draw arrows
 		if (pen.style() != Qt::NoPen)
 		{
-			if (firstLineLength > startArrowSize)
+			if (firstLineLength > startArrowSize && isDetailVisible(painter, startArrowSize))
 				style->drawArrow(painter, startArrowStyle, startArrowSize, p0, firstLineAngle, pen, sceneBrush);
-			if (lastLineLength > endArrowSize)
+			if (lastLineLength > endArrowSize && isDetailVisible(painter, endArrowSize))
 				style->drawArrow(painter, endArrowStyle, endArrowSize, p3, 180 + lastLineAngle, pen, sceneBrush);
 		}
 
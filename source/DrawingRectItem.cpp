@@ -101,6 +101,7 @@ void DrawingRectItem::setCornerRadii(qreal radiusX, qreal radiusY)
 {
 	mCornerRadiusX = radiusX;
 	mCornerRadiusY = radiusY;
+	prepareGeometryChange();
 }
 
 qreal DrawingRectItem::cornerRadiusX() const
@@ -170,7 +171,7 @@ void DrawingRectItem::render(QPainter* painter)
 		QPen scenePen = painter->pen();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 
 		// Draw rect
@@ -23,11 +23,23 @@
 #include "DrawingItem.h"
 #include "DrawingItemStyle.h"
 #include "DrawingItemPoint.h"
+#include "DrawingSceneSnapshot.h"
 
 DrawingScene::DrawingScene() : QObject()
 {
 	mSceneRect = QRectF(0, 0, 11000, 8500);
 	mBackgroundBrush = Qt::white;
+	mUsesDisplayLists = false;
+	mBatchesDisplayLists = true;
+	mItemsValid = true;
+	mEntireSceneChanged = false;
+	mSharedStyleVersion = DrawingItemStyle::sharedVersion();
+	mDefaultStyleVersion = DrawingItemStyle::defaultVersion();
+	mRenderView = nullptr;
+
+	QStringList classNames = DrawingItemStyle::classNames();
+	for(auto nameIter = classNames.begin(); nameIter != classNames.end(); nameIter++)
+		mStyleClassVersions.insert(*nameIter, DrawingItemStyle::classVersion(*nameIter));
 }
 
 DrawingScene::~DrawingScene()
@@ -39,12 +51,14 @@ DrawingScene::~DrawingScene()
 
 void DrawingScene::setSceneRect(const QRectF& rect)
 {
+	addChangedRect(mSceneRect);
 	mSceneRect = rect;
+	addChangedRect(mSceneRect);
 }
 
 void DrawingScene::setSceneRect(qreal left, qreal top, qreal width, qreal height)
 {
-	mSceneRect = QRectF(left, top, width, height);
+	setSceneRect(QRectF(left, top, width, height));
 }
 
 QRectF DrawingScene::sceneRect() const
@@ -57,6 +71,7 @@ QRectF DrawingScene::sceneRect() const
 void DrawingScene::setBackgroundBrush(const QBrush& brush)
 {
 	mBackgroundBrush = brush;
+	addChangedScene();
 }
 
 QBrush DrawingScene::backgroundBrush() const
@@ -64,14 +79,46 @@ QBrush DrawingScene::backgroundBrush() const
 	return mBackgroundBrush;
 }
 
+void DrawingScene::setUsesDisplayLists(bool enabled)
+{
+	// Free the memory used by the items' recordings
+	if (mUsesDisplayLists && !enabled)
+	{
+		QList<DrawingItem*> sceneItems = items();
+		for(auto itemIter = sceneItems.begin(); itemIter != sceneItems.end(); itemIter++)
+			(*itemIter)->releaseDisplayList();
+	}
+
+	mUsesDisplayLists = enabled;
+	addChangedScene();
+}
+
+bool DrawingScene::usesDisplayLists() const
+{
+	return mUsesDisplayLists;
+}
+
+void DrawingScene::setBatchesDisplayLists(bool enabled)
+{
+	mBatchesDisplayLists = enabled;
+	addChangedScene();
+}
+
+bool DrawingScene::batchesDisplayLists() const
+{
+	return mBatchesDisplayLists;
+}
+
 //==================================================================================================
 
 void DrawingScene::addItem(DrawingItem* item)
 {
 	if (item && item->mScene == nullptr)
 	{
-		mItems.append(item);
+		mItemOrder.append(item);
+		mItemsValid = false;
 		item->mScene = this;
+		indexItem(item);
 	}
 }
 
@@ -79,8 +126,10 @@ void DrawingScene::insertItem(int index, DrawingItem* item)
 {
 	if (item && item->mScene == nullptr)
 	{
-		mItems.insert(index, item);
+		mItemOrder.insert(index, item);
+		mItemsValid = false;
 		item->mScene = this;
+		indexItem(item);
 	}
 }
 
@@ -88,56 +137,119 @@ void DrawingScene::removeItem(DrawingItem* item)
 {
 	if (item && item->mScene == this)
 	{
-		mItems.removeAll(item);
+		unindexItem(item);
+		mItemOrder.remove(item);
+		mItemsValid = false;
 		item->mScene = nullptr;
 	}
 }
 
 void DrawingScene::clearItems()
 {
-	DrawingItem* item = nullptr;
+	QList<DrawingItem*> items = DrawingScene::items();
+
+	mItemOrder.clear();
+	mItems.clear();
+	mItemsValid = true;
+	mItemIndex.clear();
+	mItemDensity.clear();
+	mDirtyIndexItems.clear();
+	mStyleClassItems.clear();
+	mItemStyleClasses.clear();
+	addChangedScene();
 
-	while (!mItems.empty())
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
 	{
-		item = mItems.first();
-		removeItem(item);
-		delete item;
-		item = nullptr;
+		(*itemIter)->mScene = nullptr;
+		delete *itemIter;
 	}
 }
 
 void DrawingScene::setItems(const QList<DrawingItem*>& items)
 {
-	for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	QSet<DrawingItem*> newItems(items.begin(), items.end());
+#else
+	QSet<DrawingItem*> newItems = items.toSet();
+#endif
+	QList<DrawingItem*> oldItems = DrawingScene::items();
+
+	for(auto itemIter = oldItems.begin(); itemIter != oldItems.end(); itemIter++)
 	{
 		(*itemIter)->mScene = nullptr;
-		if (!items.contains(*itemIter)) delete *itemIter;
+		if (!newItems.contains(*itemIter)) delete *itemIter;
 	}
 
-	mItems = items;
+	mItemOrder.clear();
+	mItemsValid = false;
+	mItemIndex.clear();
+	mItemDensity.clear();
+	mDirtyIndexItems.clear();
+	mStyleClassItems.clear();
+	mItemStyleClasses.clear();
+	addChangedScene();
 
-	for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		mItemOrder.append(*itemIter);
 		(*itemIter)->mScene = this;
+		indexItem(*itemIter);
+	}
 }
 
 QList<DrawingItem*> DrawingScene::items() const
 {
+	if (!mItemsValid)
+	{
+		mItems = mItemOrder.toList();
+		mItemsValid = true;
+	}
+
 	return mItems;
 }
 
+QHash<DrawingItem*,int> DrawingScene::itemIndices(const QList<DrawingItem*>& items) const
+{
+	QHash<DrawingItem*,int> indices;
+	int index = -1;
+
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		index = mItemOrder.indexOf(*itemIter);
+		if (index >= 0) indices.insert(*itemIter, index);
+	}
+
+	return indices;
+}
+
+//==================================================================================================
+
+void DrawingScene::updateItemIndex(DrawingItem* item)
+{
+	if (item)
+	{
+		DrawingItem* topLevelItem = item;
+		while (topLevelItem->mParent) topLevelItem = topLevelItem->mParent;
+
+		if (topLevelItem->mScene == this) indexItem(item);
+	}
+}
+
 //==================================================================================================
 
 QList<DrawingItem*> DrawingScene::visibleItems() const
 {
 	QList<DrawingItem*> foundItems;
-	findItems(mItems, foundItems);
+	findItems(items(), foundItems);
 	return foundItems;
 }
 
 QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QPointF& pos) const
 {
 	QList<DrawingItem*> items;
-	QList<DrawingItem*> visibleItems = DrawingScene::visibleItems();
+	qreal tolerance = indexTolerance(view);
+	QList<DrawingItem*> visibleItems = indexedItems(
+		QRectF(pos, pos).adjusted(-tolerance, -tolerance, tolerance, tolerance));
 
 	for(auto itemIter = visibleItems.begin(); itemIter != visibleItems.end(); itemIter++)
 	{
@@ -150,7 +262,9 @@ QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QP
 QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QRectF& rect, Qt::ItemSelectionMode selectMode) const
 {
 	QList<DrawingItem*> items;
-	QList<DrawingItem*> visibleItems = DrawingScene::visibleItems();
+	qreal tolerance = indexTolerance(view);
+	QList<DrawingItem*> visibleItems = indexedItems(
+		rect.normalized().adjusted(-tolerance, -tolerance, tolerance, tolerance));
 
 	for(auto itemIter = visibleItems.begin(); itemIter != visibleItems.end(); itemIter++)
 	{
@@ -164,7 +278,9 @@ QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QR
 QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QPainterPath& path, Qt::ItemSelectionMode selectMode) const
 {
 	QList<DrawingItem*> items;
-	QList<DrawingItem*> visibleItems = DrawingScene::visibleItems();
+	qreal tolerance = indexTolerance(view);
+	QList<DrawingItem*> visibleItems = indexedItems(
+		path.boundingRect().adjusted(-tolerance, -tolerance, tolerance, tolerance));
 
 	for(auto itemIter = visibleItems.begin(); itemIter != visibleItems.end(); itemIter++)
 	{
@@ -178,7 +294,9 @@ QList<DrawingItem*> DrawingScene::visibleItems(const DrawingView* view, const QP
 DrawingItem* DrawingScene::visibleItemAt(const DrawingView* view, const QPointF& pos) const
 {
 	DrawingItem* item = nullptr;
-	QList<DrawingItem*> visibleItems = DrawingScene::visibleItems();
+	qreal tolerance = indexTolerance(view);
+	QList<DrawingItem*> visibleItems = indexedItems(
+		QRectF(pos, pos).adjusted(-tolerance, -tolerance, tolerance, tolerance));
 
 	auto itemIter = visibleItems.end();
 	while (item == nullptr && itemIter != visibleItems.begin())
@@ -206,23 +324,81 @@ void DrawingScene::addItems(const QList<DrawingItem*>& items)
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
 		addItem(*itemIter);
 
-	emit numberOfItemsChanged(mItems.size());
+	emit numberOfItemsChanged(mItemOrder.size());
 }
 
 void DrawingScene::insertItems(const QList<DrawingItem*>& items, const QHash<DrawingItem*,int>& index)
 {
+	QList< QPair<int,DrawingItem*> > itemsToInsert;
+
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
-		insertItem(index[*itemIter], *itemIter);
+	{
+		if (*itemIter && (*itemIter)->mScene == nullptr)
+		{
+			itemsToInsert.append(qMakePair(index.value(*itemIter, mItemOrder.size() + items.size()), *itemIter));
+			(*itemIter)->mScene = this;
+		}
+	}
+
+	std::stable_sort(itemsToInsert.begin(), itemsToInsert.end(),
+		[](const QPair<int,DrawingItem*>& item1, const QPair<int,DrawingItem*>& item2) {
+			return item1.first < item2.first; });
+
+	// Each index refers to the item's position in the final list, so insert the items in order
+	// of increasing index
+	for(auto itemIter = itemsToInsert.begin(); itemIter != itemsToInsert.end(); itemIter++)
+	{
+		mItemOrder.insert(itemIter->first, itemIter->second);
+		indexItem(itemIter->second);
+	}
 
-	emit numberOfItemsChanged(mItems.size());
+	if (!itemsToInsert.isEmpty()) mItemsValid = false;
+
+	emit numberOfItemsChanged(mItemOrder.size());
 }
 
 void DrawingScene::removeItems(const QList<DrawingItem*>& items)
 {
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
-		removeItem(*itemIter);
+	{
+		if (*itemIter && (*itemIter)->mScene == this)
+		{
+			unindexItem(*itemIter);
+			mItemOrder.remove(*itemIter);
+			mItemsValid = false;
+			(*itemIter)->mScene = nullptr;
+		}
+	}
+
+	emit numberOfItemsChanged(mItemOrder.size());
+}
+
+//==================================================================================================
+
+void DrawingScene::reorderItems(const QList<DrawingItem*>& items, const QHash<DrawingItem*,int>& indices)
+{
+	QList< QPair<int,DrawingItem*> > itemsToMove;
+
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		if (mItemOrder.contains(*itemIter) && indices.contains(*itemIter))
+		{
+			itemsToMove.append(qMakePair(indices.value(*itemIter), *itemIter));
+			mItemOrder.remove(*itemIter);
+		}
+	}
+
+	std::stable_sort(itemsToMove.begin(), itemsToMove.end(),
+		[](const QPair<int,DrawingItem*>& item1, const QPair<int,DrawingItem*>& item2) {
+			return item1.first < item2.first; });
+
+	for(auto itemIter = itemsToMove.begin(); itemIter != itemsToMove.end(); itemIter++)
+	{
+		mItemOrder.insert(itemIter->first, itemIter->second);
+		mDirtyIndexItems.insert(itemIter->second);
+	}
 
-	emit numberOfItemsChanged(mItems.size());
+	if (!itemsToMove.isEmpty()) mItemsValid = false;
 }
 
 //==================================================================================================
@@ -361,7 +537,48 @@ void DrawingScene::drawBackground(QPainter* painter)
 
 void DrawingScene::drawItems(QPainter* painter)
 {
-	drawItems(painter, mItems);
+	drawItems(painter, items());
+}
+
+void DrawingScene::drawOverview(QPainter* painter)
+{
+	// The painter's clip region (in scene coordinates) is the area of the scene being painted
+	QRectF exposedRect = (painter->hasClipping()) ? painter->clipBoundingRect() : mSceneRect;
+	qreal deviceScale = qSqrt(qAbs(painter->combinedTransform().determinant()));
+
+	updateDirtyIndexItems();
+
+	if (deviceScale > 0)
+	{
+		// Draw the density of the small items in the inverse of the background color
+		QColor backgroundColor = mBackgroundBrush.color();
+		QColor densityColor(255 - backgroundColor.red(), 255 - backgroundColor.green(),
+			255 - backgroundColor.blue());
+
+		QRectF imageRect;
+		QImage densityImage = mItemDensity.densityImage(exposedRect, 1 / deviceScale,
+			densityColor, imageRect);
+		if (!densityImage.isNull()) painter->drawImage(imageRect, densityImage);
+
+		// Draw the items that are too large to be included in the density image normally, in
+		// order.  The threshold depends on the scale, since the image uses coarser cells as the
+		// scene is drawn smaller.
+		qreal densityCellSize = mItemDensity.levelCellSize(1 / deviceScale);
+		QList<DrawingItem*> largeItems = mItemIndex.items(exposedRect, densityCellSize);
+		QList<QPair<int,DrawingItem*>> orderedItems;
+		for(auto itemIter = largeItems.begin(); itemIter != largeItems.end(); itemIter++)
+		{
+			if ((*itemIter)->mParent == nullptr)
+				orderedItems.append(qMakePair(mItemOrder.indexOf(*itemIter), *itemIter));
+		}
+		std::sort(orderedItems.begin(), orderedItems.end());
+
+		largeItems.clear();
+		for(auto itemIter = orderedItems.begin(); itemIter != orderedItems.end(); itemIter++)
+			largeItems.append(itemIter->second);
+
+		drawItems(painter, largeItems, exposedRect);
+	}
 }
 
 void DrawingScene::drawForeground(QPainter* painter)
@@ -385,32 +602,375 @@ void DrawingScene::findItems(const QList<DrawingItem*>& items, QList<DrawingItem
 	}
 }
 
+QList<DrawingItem*> DrawingScene::indexedItems(const QRectF& sceneRect) const
+{
+	QList<DrawingItem*> items;
+
+	updateDirtyIndexItems();
+
+	QList<DrawingItem*> candidateItems = mItemIndex.items(sceneRect);
+	QList< QPair<QVector<int>,DrawingItem*> > sortedItems;
+
+	// Build a sort key for each visible candidate from the item's index at each level of the
+	// item tree, so that the result matches the order returned by visibleItems()
+	for(auto itemIter = candidateItems.begin(); itemIter != candidateItems.end(); itemIter++)
+	{
+		QVector<int> sortKey;
+		bool visible = true;
+
+		for(DrawingItem* item = *itemIter; visible && item; item = item->mParent)
+		{
+			visible = item->isVisible();
+			if (item->mParent) sortKey.prepend(item->mChildIndex);
+			else sortKey.prepend(mItemOrder.indexOf(item));
+		}
+
+		if (visible) sortedItems.append(qMakePair(sortKey, *itemIter));
+	}
+
+	std::sort(sortedItems.begin(), sortedItems.end(),
+		[](const QPair<QVector<int>,DrawingItem*>& item1, const QPair<QVector<int>,DrawingItem*>& item2) {
+			return std::lexicographical_compare(item1.first.begin(), item1.first.end(),
+				item2.first.begin(), item2.first.end()); });
+
+	for(auto itemIter = sortedItems.begin(); itemIter != sortedItems.end(); itemIter++)
+		items.append(itemIter->second);
+
+	return items;
+}
+
+qreal DrawingScene::indexTolerance(const DrawingView* view) const
+{
+	qreal tolerance = 0;
+
+	if (view)
+	{
+		// Items may match a little outside of their bounding rect, either because
+		// itemAdjustedShape() increases their pen width or because the user clicked on one of
+		// their item points.  Both of these are sized in view pixels.
+		const int toleranceHint = 8 * view->devicePixelRatio() * view->devicePixelRatio();
+
+		QPointF delta = view->mapToScene(QPoint(toleranceHint, toleranceHint)) - view->mapToScene(QPoint(0, 0));
+		tolerance = qMax(qAbs(delta.x()), qAbs(delta.y()));
+	}
+
+	return tolerance;
+}
+
+void DrawingScene::updateDirtyIndexItems() const
+{
+	// Only modify the dirty set if needed, since this is also called while rendering concurrently
+	if (!mDirtyIndexItems.isEmpty())
+	{
+		for(auto itemIter = mDirtyIndexItems.begin(); itemIter != mDirtyIndexItems.end(); itemIter++)
+			indexItem(*itemIter);
+
+		mDirtyIndexItems.clear();
+	}
+}
+
+void DrawingScene::indexItem(DrawingItem* item) const
+{
+	QRectF sceneRect = item->sceneBoundingRect();
+
+	// Both the old and new area of the item need to be repainted
+	if (mItemIndex.contains(item) && mItemIndex.itemRect(item) != sceneRect)
+		addChangedRect(mItemIndex.itemRect(item));
+	addChangedRect(sceneRect);
+
+	mItemIndex.updateItem(item, sceneRect);
+
+	// Only top-level items are summarized for the overview
+	if (item->mParent == nullptr && item->isVisible()) mItemDensity.updateItem(item, sceneRect);
+	else mItemDensity.removeItem(item);
+
+	// Keep track of which items use each style class, so that editing a class only updates them
+	QString className = (item->style()) ? item->style()->styleClass() : QString();
+	if (mItemStyleClasses.value(item) != className)
+	{
+		if (mItemStyleClasses.contains(item)) mStyleClassItems[mItemStyleClasses.take(item)].remove(item);
+		if (!className.isEmpty())
+		{
+			mStyleClassItems[className].insert(item);
+			mItemStyleClasses.insert(item, className);
+		}
+	}
+
+	for(auto childIter = item->mChildren.begin(); childIter != item->mChildren.end(); childIter++)
+		indexItem(*childIter);
+}
+
+void DrawingScene::unindexItem(DrawingItem* item)
+{
+	if (mItemIndex.contains(item)) addChangedRect(mItemIndex.itemRect(item));
+	mItemIndex.removeItem(item);
+	mItemDensity.removeItem(item);
+	mDirtyIndexItems.remove(item);
+	if (mItemStyleClasses.contains(item)) mStyleClassItems[mItemStyleClasses.take(item)].remove(item);
+
+	for(auto childIter = item->mChildren.begin(); childIter != item->mChildren.end(); childIter++)
+		unindexItem(*childIter);
+}
+
+void DrawingScene::addChangedRect(const QRectF& sceneRect) const
+{
+	const int maximumChangedRects = 1024;
+
+	// Once the entire scene has changed, there is no need to keep track of individual rects
+	if (!mEntireSceneChanged)
+	{
+		if (mChangedRects.size() < maximumChangedRects) mChangedRects.append(sceneRect);
+		else addChangedScene();
+	}
+}
+
+void DrawingScene::addChangedScene() const
+{
+	mChangedRects.clear();
+	mEntireSceneChanged = true;
+}
+
+void DrawingScene::prepareConcurrentRender(const QRectF& sceneRect) const
+{
+	updateDirtyIndexItems();
+	items();
+
+	// Fill each item's geometry caches and display list now so that they are not written to while
+	// rendering.  Styles resolve their values when they change, so they are only read.
+	QList<DrawingItem*> items = mItemIndex.items(sceneRect);
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		(*itemIter)->sceneBoundingRect();
+		if (mUsesDisplayLists) (*itemIter)->displayList();
+	}
+}
+
+void DrawingScene::processChanges()
+{
+	if (mSharedStyleVersion != DrawingItemStyle::sharedVersion())
+	{
+		QStringList classNames = DrawingItemStyle::classNames();
+
+		if (mDefaultStyleVersion != DrawingItemStyle::defaultVersion())
+		{
+			// A change to the default style values may affect any item, so re-index all of the
+			// items and repaint the entire scene once
+			QList<DrawingItem*> sceneItems = items();
+			for(auto itemIter = sceneItems.begin(); itemIter != sceneItems.end(); itemIter++)
+				mDirtyIndexItems.insert(*itemIter);
+
+			addChangedScene();
+			mDefaultStyleVersion = DrawingItemStyle::defaultVersion();
+		}
+		else
+		{
+			// Only the items that use an edited style class are re-indexed, which also repaints
+			// their old and new areas
+			for(auto nameIter = classNames.begin(); nameIter != classNames.end(); nameIter++)
+			{
+				if (mStyleClassVersions.value(*nameIter) != DrawingItemStyle::classVersion(*nameIter))
+				{
+					QSet<DrawingItem*> classItems = mStyleClassItems.value(*nameIter);
+					for(auto itemIter = classItems.begin(); itemIter != classItems.end(); itemIter++)
+						mDirtyIndexItems.insert(*itemIter);
+				}
+			}
+		}
+
+		for(auto nameIter = classNames.begin(); nameIter != classNames.end(); nameIter++)
+			mStyleClassVersions.insert(*nameIter, DrawingItemStyle::classVersion(*nameIter));
+		mSharedStyleVersion = DrawingItemStyle::sharedVersion();
+	}
+
+	updateDirtyIndexItems();
+
+	if (mEntireSceneChanged || !mChangedRects.isEmpty())
+	{
+		QList<QRectF> changedRects = mChangedRects;
+
+		mChangedRects.clear();
+		mEntireSceneChanged = false;
+
+		emit changed(changedRects);
+	}
+}
+
+//==================================================================================================
+
 void DrawingScene::drawItems(QPainter* painter, const QList<DrawingItem*>& items)
 {
+	// The painter's clip region (in scene coordinates) is the area of the scene being painted
+	QRectF exposedRect = (painter->hasClipping()) ? painter->clipBoundingRect() : QRectF();
+
+	updateDirtyIndexItems();
+
+	drawItems(painter, items, exposedRect);
+}
+
+void DrawingScene::drawItems(QPainter* painter, const QList<DrawingItem*>& items, const QRectF& exposedRect)
+{
+	// Items that are smaller than the view's minimum item size are drawn as placeholders.  Item
+	// transforms only rotate and flip, so the scale is the same for every item.
+	qreal deviceScale = qSqrt(qAbs(painter->combinedTransform().determinant()));
+	qreal minimumItemSize = (mRenderView && deviceScale > 0) ?
+		mRenderView->minimumItemSize() / deviceScale : 0;
+	qreal minimumRenderPenWidth = (mRenderView) ? mRenderView->minimumRenderPenWidth() : 0;
+	qreal minimumTextSize = (mRenderView) ? mRenderView->minimumTextSize() : 0;
+
+	// Consecutive items that record a single primitive with the same style are collected into a
+	// batch and drawn together.  The batch is drawn before any other item so that the items are
+	// still painted in order.
+	DrawingDisplayListBatch batch;
+
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
 	{
 		if ((*itemIter)->isVisible())
 		{
-			painter->translate((*itemIter)->position());
-			painter->setTransform((*itemIter)->transformInverted(), true);
+			bool itemExposed = itemIsExposed(*itemIter, exposedRect);
+			bool itemIsPlaceholder = false;
+			bool itemBatched = false;
 
-			(*itemIter)->render(painter);
+			if (itemExposed)
+			{
+				QRectF itemRect = (*itemIter)->cachedBoundingRect();
+				itemIsPlaceholder = (itemRect.width() < minimumItemSize && itemRect.height() < minimumItemSize);
+			}
 
-			//painter->save();
-			//painter->setBrush(QColor(255, 0, 255, 128));
-			//painter->setPen(QPen(QColor(255, 0, 255, 128), 1));
-			//painter->drawPath(itemAdjustedShape(*itemIter));
-			//painter->restore();
+			if (mUsesDisplayLists && mBatchesDisplayLists && itemExposed && !itemIsPlaceholder &&
+				(*itemIter)->mChildren.isEmpty())
+			{
+				QPointF position = (*itemIter)->position();
+				QTransform itemTransform = (*itemIter)->transformInverted() *
+					QTransform::fromTranslate(position.x(), position.y());
+				const DrawingDisplayList& displayList = (*itemIter)->displayList();
+
+				itemBatched = batch.add(displayList, itemTransform);
+				if (!itemBatched && !batch.isEmpty())
+				{
+					batch.draw(painter, minimumRenderPenWidth);
+					itemBatched = batch.add(displayList, itemTransform);
+				}
+			}
 
-			if (!(*itemIter)->mChildren.isEmpty())
-				drawItems(painter, (*itemIter)->mChildren);
+			if (!itemBatched)
+			{
+				batch.draw(painter, minimumRenderPenWidth);
+
+				painter->translate((*itemIter)->position());
+				painter->setTransform((*itemIter)->transformInverted(), true);
+
+				if (itemExposed)
+				{
+					if (itemIsPlaceholder)
+						drawItemPlaceholder(painter, *itemIter, deviceScale);
+					else if (mUsesDisplayLists)
+						(*itemIter)->displayList().draw(painter, minimumRenderPenWidth, minimumTextSize);
+					else
+						(*itemIter)->render(painter);
+				}
+
+				//painter->save();
+				//painter->setBrush(QColor(255, 0, 255, 128));
+				//painter->setPen(QPen(QColor(255, 0, 255, 128), 1));
+				//painter->drawPath(itemAdjustedShape(*itemIter));
+				//painter->restore();
+
+				// Children are not necessarily inside their parent's bounding rect, so each child is
+				// checked separately
+				if (!(*itemIter)->mChildren.isEmpty())
+					drawItems(painter, (*itemIter)->mChildren, exposedRect);
+
+				painter->setTransform((*itemIter)->transform(), true);
+				painter->translate(-(*itemIter)->position());
+			}
+		}
+	}
+
+	batch.draw(painter, minimumRenderPenWidth);
+}
+
+void DrawingScene::snapshotItems(DrawingSceneSnapshot* snapshot, const QRectF& exposedRect)
+{
+	// Only the items in the exposed rect are visited, using the spatial index.  Each item's
+	// display list is shared with the snapshot, so render() is only called for items that have
+	// changed since their display list was last used.
+	qreal deviceScale = qSqrt(qAbs(snapshot->transform().determinant()));
+	qreal minimumItemSize = (mRenderView && deviceScale > 0) ?
+		mRenderView->minimumItemSize() / deviceScale : 0;
+
+	QList<DrawingItem*> items = indexedItems(exposedRect);
 
-			painter->setTransform((*itemIter)->transform(), true);
-			painter->translate(-(*itemIter)->position());
+	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
+	{
+		QRectF itemRect = (*itemIter)->cachedBoundingRect();
+
+		if (itemRect.width() < minimumItemSize && itemRect.height() < minimumItemSize)
+		{
+			QColor color = itemPlaceholderColor(*itemIter);
+			if (color.alpha() > 0)
+			{
+				snapshot->addPlaceholder(itemPlaceholderRect(*itemIter, deviceScale), color,
+					(*itemIter)->sceneTransform());
+			}
+		}
+		else
+		{
+			snapshot->addItem((*itemIter)->displayList(), (*itemIter)->sceneTransform(),
+				mItemIndex.itemRect(*itemIter));
 		}
 	}
 }
 
+bool DrawingScene::itemIsExposed(DrawingItem* item, const QRectF& exposedRect) const
+{
+	bool exposed = true;
+
+	if (!exposedRect.isNull())
+	{
+		// Use the bounds stored in the spatial index when available; items that are not in the
+		// scene (such as a view's new items) are mapped directly
+		QRectF itemRect = (mItemIndex.contains(item)) ? mItemIndex.itemRect(item) :
+			item->sceneBoundingRect();
+
+		exposed = (itemRect.left() <= exposedRect.right() && exposedRect.left() <= itemRect.right() &&
+			itemRect.top() <= exposedRect.bottom() && exposedRect.top() <= itemRect.bottom());
+	}
+
+	return exposed;
+}
+
+void DrawingScene::drawItemPlaceholder(QPainter* painter, DrawingItem* item, qreal deviceScale)
+{
+	QColor color = itemPlaceholderColor(item);
+	if (color.alpha() > 0) painter->fillRect(itemPlaceholderRect(item, deviceScale), color);
+}
+
+QRectF DrawingScene::itemPlaceholderRect(DrawingItem* item, qreal deviceScale) const
+{
+	// A box the size of the item, but at least one pixel wide
+	QRectF itemRect = item->cachedBoundingRect();
+	qreal minimumSize = 1 / deviceScale;
+	QSizeF placeholderSize(qMax(itemRect.width(), minimumSize), qMax(itemRect.height(), minimumSize));
+
+	return QRectF(itemRect.center().x() - placeholderSize.width() / 2,
+		itemRect.center().y() - placeholderSize.height() / 2,
+		placeholderSize.width(), placeholderSize.height());
+}
+
+QColor DrawingScene::itemPlaceholderColor(DrawingItem* item) const
+{
+	// Use the item's pen color, or its brush color if it has no pen
+	QColor color;
+	DrawingItemStyle* style = item->style();
+	if (style)
+	{
+		QPen pen = style->pen();
+		color = (pen.style() != Qt::NoPen) ? pen.color() : style->brush().color();
+	}
+
+	return color;
+}
+
 //==================================================================================================
 
 bool DrawingScene::itemMatchesPoint(const DrawingView* view, DrawingItem* item, const QPointF& scenePos) const
@@ -449,16 +1009,16 @@ bool DrawingScene::itemMatchesRect(const DrawingView* view, DrawingItem* item, c
 		switch (mode)
 		{
 		case Qt::IntersectsItemShape:
-			match = item->shape().intersects(item->mapFromScene(rect).boundingRect());
+			match = item->cachedShape().intersects(item->mapFromScene(rect).boundingRect());
 			break;
 		case Qt::ContainsItemShape:
-			match = rect.contains(item->mapToScene(item->shape().boundingRect()).boundingRect());
+			match = rect.contains(item->sceneTransform().mapRect(item->cachedShape().boundingRect()));
 			break;
 		case Qt::IntersectsItemBoundingRect:
-			match = rect.intersects(item->mapToScene(item->boundingRect()).boundingRect());
+			match = rect.intersects(item->sceneBoundingRect());
 			break;
 		default:	// Qt::ContainsItemBoundingRect
-			match = rect.contains(item->mapToScene(item->boundingRect()).boundingRect());
+			match = rect.contains(item->sceneBoundingRect());
 			break;
 		}
 
@@ -493,16 +1053,16 @@ bool DrawingScene::itemMatchesPath(const DrawingView* view, DrawingItem* item, c
 		switch (mode)
 		{
 		case Qt::IntersectsItemShape:
-			match = item->shape().intersects(item->mapFromScene(path));
+			match = item->cachedShape().intersects(item->mapFromScene(path));
 			break;
 		case Qt::ContainsItemShape:
-			match = path.contains(item->mapToScene(item->shape().boundingRect()).boundingRect());
+			match = path.contains(item->sceneTransform().mapRect(item->cachedShape().boundingRect()));
 			break;
 		case Qt::IntersectsItemBoundingRect:
-			match = path.intersects(item->mapToScene(item->boundingRect()).boundingRect());
+			match = path.intersects(item->sceneBoundingRect());
 			break;
 		default:	// Qt::ContainsItemBoundingRect
-			match = path.contains(item->mapToScene(item->boundingRect()).boundingRect());
+			match = path.contains(item->sceneBoundingRect());
 			break;
 		}
 
@@ -531,36 +1091,8 @@ QPainterPath DrawingScene::itemAdjustedShape(const DrawingView* view, DrawingIte
 {
 	QPainterPath adjustedShape;
 
-	if (view && item)
-	{
-		DrawingItemStyle* style = item->style();
-		if (style)
-		{
-			qreal penWidth = 0;
-
-			// Determine existing item's pen width
-			QVariant value = style->valueLookup(DrawingItemStyle::PenWidth);
-			if (value.isValid()) penWidth = value.toDouble();
-
-			// Determine minimum pen width
-			qreal minimumPenWidth = view->minimumPenWidth(item);
-
-			if (0 < penWidth && penWidth < minimumPenWidth)
-			{
-				// Make it easier to select items when zoomed out by increasing pen width
-				bool styleHadPenWidth = style->hasValue(DrawingItemStyle::PenWidth);
-				if (styleHadPenWidth) penWidth = style->value(DrawingItemStyle::PenWidth).toDouble();
-
-				style->setValue(DrawingItemStyle::PenWidth, QVariant(minimumPenWidth));
-				adjustedShape = item->shape();
-
-				if (styleHadPenWidth) style->setValue(DrawingItemStyle::PenWidth, QVariant(penWidth));
-				else style->unsetValue(DrawingItemStyle::PenWidth);
-			}
-			else adjustedShape = item->shape();
-		}
-		else adjustedShape = item->shape();
-	}
+	// Make it easier to select items when zoomed out by increasing pen width
+	if (view && item) adjustedShape = item->cachedHitShape(view->minimumPenWidth(item));
 
 	return adjustedShape;
 }
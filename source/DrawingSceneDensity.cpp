@@ -0,0 +1,219 @@
+/* DrawingSceneDensity.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingSceneDensity.h"
+
+DrawingSceneDensity::DrawingSceneDensity(qreal cellSize)
+{
+	const int levelCount = 8;
+
+	mCellSize = (cellSize > 0) ? cellSize : 32;
+	mLevels.resize(levelCount);
+}
+
+DrawingSceneDensity::~DrawingSceneDensity()
+{
+	clear();
+}
+
+//==================================================================================================
+
+qreal DrawingSceneDensity::cellSize() const
+{
+	return mCellSize;
+}
+
+int DrawingSceneDensity::levelFactor()
+{
+	return 4;
+}
+
+qreal DrawingSceneDensity::levelCellSize(qreal minimumCellSize) const
+{
+	return mCellSize * qPow(levelFactor(), level(minimumCellSize));
+}
+
+//==================================================================================================
+
+void DrawingSceneDensity::updateItem(DrawingItem* item, const QRectF& sceneRect)
+{
+	if (item)
+	{
+		QRectF rect = sceneRect.normalized();
+		QPointF center = rect.center();
+		qreal itemSize = qMax(rect.width(), rect.height());
+		const qreal cellLimit = 1.0E9;
+
+		// Count the item starting from the finest grid whose cells are at least as large as it
+		ItemCell cell;
+		cell.level = level(itemSize);
+		qreal cellSize = levelCellSize(itemSize);
+
+		bool counted = (itemSize <= cellSize &&
+			qAbs(center.x() / cellSize) < cellLimit && qAbs(center.y() / cellSize) < cellLimit);
+
+		if (counted)
+		{
+			cell.column = qFloor(center.x() / cellSize);
+			cell.row = qFloor(center.y() / cellSize);
+
+			auto cellIter = mItemCells.find(item);
+			if (cellIter == mItemCells.end())
+			{
+				mItemCells.insert(item, cell);
+				addToLevels(cell, 1);
+			}
+			else if (cellIter.value().level != cell.level || cellIter.value().column != cell.column ||
+				cellIter.value().row != cell.row)
+			{
+				addToLevels(cellIter.value(), -1);
+				cellIter.value() = cell;
+				addToLevels(cell, 1);
+			}
+		}
+		else removeItem(item);
+	}
+}
+
+void DrawingSceneDensity::removeItem(DrawingItem* item)
+{
+	auto cellIter = mItemCells.find(item);
+	if (cellIter != mItemCells.end())
+	{
+		addToLevels(cellIter.value(), -1);
+		mItemCells.erase(cellIter);
+	}
+}
+
+void DrawingSceneDensity::clear()
+{
+	for(auto levelIter = mLevels.begin(); levelIter != mLevels.end(); levelIter++)
+		levelIter->clear();
+
+	mItemCells.clear();
+}
+
+//==================================================================================================
+
+QImage DrawingSceneDensity::densityImage(const QRectF& sceneRect, qreal minimumCellSize,
+	const QColor& color, QRectF& imageRect) const
+{
+	const qint64 maximumPixelCount = 4096 * 4096;
+
+	QImage image;
+	imageRect = QRectF();
+
+	// Use the finest grid whose cells are at least the minimum size
+	int level = DrawingSceneDensity::level(minimumCellSize);
+	qreal levelCellSize = DrawingSceneDensity::levelCellSize(minimumCellSize);
+
+	qreal left = qFloor(sceneRect.left() / levelCellSize);
+	qreal top = qFloor(sceneRect.top() / levelCellSize);
+	qreal right = qFloor(sceneRect.right() / levelCellSize);
+	qreal bottom = qFloor(sceneRect.bottom() / levelCellSize);
+	qreal pixelCount = (right - left + 1) * (bottom - top + 1);
+
+	if (sceneRect.isValid() && pixelCount <= maximumPixelCount)
+	{
+		int imageLeft = (int)left, imageTop = (int)top;
+		int imageWidth = (int)(right - left + 1), imageHeight = (int)(bottom - top + 1);
+		const QHash<quint64,int>& cells = mLevels[level];
+
+		image = QImage(imageWidth, imageHeight, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+		imageRect = QRectF(left * levelCellSize, top * levelCellSize,
+			imageWidth * levelCellSize, imageHeight * levelCellSize);
+
+		// Any occupied cell is drawn at least partly opaque so that isolated items stay visible;
+		// the alpha increases with the average number of items in each of the finest cells
+		qreal finestCellsPerCell = levelCellSize * levelCellSize / (mCellSize * mCellSize);
+		auto cellColor = [&color, finestCellsPerCell](int count) -> QRgb {
+			int alpha = 64 + (int)(191 * qMin(1.0, count / finestCellsPerCell));
+			return qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha * color.alpha() / 255));
+		};
+
+		// Visit either every cell in the image or every occupied cell, whichever is fewer
+		if (pixelCount <= cells.size())
+		{
+			for(int row = 0; row < imageHeight; row++)
+			{
+				QRgb* scanLine = reinterpret_cast<QRgb*>(image.scanLine(row));
+
+				for(int column = 0; column < imageWidth; column++)
+				{
+					int count = cells.value(cellKey(imageLeft + column, imageTop + row), 0);
+					if (count > 0) scanLine[column] = cellColor(count);
+				}
+			}
+		}
+		else
+		{
+			for(auto cellIter = cells.begin(); cellIter != cells.end(); cellIter++)
+			{
+				int column = (qint32)(quint32)(cellIter.key() >> 32) - imageLeft;
+				int row = (qint32)(quint32)(cellIter.key()) - imageTop;
+
+				if (0 <= column && column < imageWidth && 0 <= row && row < imageHeight)
+					reinterpret_cast<QRgb*>(image.scanLine(row))[column] = cellColor(cellIter.value());
+			}
+		}
+	}
+
+	return image;
+}
+
+//==================================================================================================
+
+int DrawingSceneDensity::level(qreal minimumCellSize) const
+{
+	int level = 0;
+	qreal levelCellSize = mCellSize;
+
+	while (level + 1 < mLevels.size() && levelCellSize < minimumCellSize)
+	{
+		level++;
+		levelCellSize *= levelFactor();
+	}
+
+	return level;
+}
+
+void DrawingSceneDensity::addToLevels(const ItemCell& cell, int count)
+{
+	int column = cell.column, row = cell.row;
+
+	for(auto levelIter = mLevels.begin() + cell.level; levelIter != mLevels.end(); levelIter++)
+	{
+		quint64 key = cellKey(column, row);
+
+		int& cellCount = (*levelIter)[key];
+		cellCount += count;
+		if (cellCount <= 0) levelIter->remove(key);
+
+		// Floor division, so that negative cells map to the correct coarser cell
+		column = (column >= 0) ? column / levelFactor() : -((-column - 1) / levelFactor()) - 1;
+		row = (row >= 0) ? row / levelFactor() : -((-row - 1) / levelFactor()) - 1;
+	}
+}
+
+quint64 DrawingSceneDensity::cellKey(int column, int row)
+{
+	return ((quint64)(quint32)column << 32) | (quint64)(quint32)row;
+}
@@ -0,0 +1,283 @@
+/* DrawingSceneIndex.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingSceneIndex.h"
+
+DrawingSceneIndex::DrawingSceneIndex(qreal cellSize)
+{
+	mCellSize = (cellSize > 0) ? cellSize : 256;
+}
+
+DrawingSceneIndex::~DrawingSceneIndex()
+{
+	clear();
+}
+
+//==================================================================================================
+
+qreal DrawingSceneIndex::cellSize() const
+{
+	return mCellSize;
+}
+
+//==================================================================================================
+
+void DrawingSceneIndex::insertItem(DrawingItem* item, const QRectF& sceneRect)
+{
+	if (item)
+	{
+		if (mItemRects.contains(item)) updateItem(item, sceneRect);
+		else
+		{
+			QRectF rect = sceneRect.normalized();
+			mItemRects.insert(item, rect);
+			addToCells(item, rect);
+		}
+	}
+}
+
+void DrawingSceneIndex::removeItem(DrawingItem* item)
+{
+	auto rectIter = mItemRects.find(item);
+	if (rectIter != mItemRects.end())
+	{
+		removeFromCells(item, rectIter.value());
+		mItemRects.erase(rectIter);
+	}
+}
+
+void DrawingSceneIndex::updateItem(DrawingItem* item, const QRectF& sceneRect)
+{
+	if (item)
+	{
+		QRectF rect = sceneRect.normalized();
+
+		auto rectIter = mItemRects.find(item);
+		if (rectIter != mItemRects.end())
+		{
+			if (rectIter.value() != rect)
+			{
+				int oldLeft = 0, oldTop = 0, oldRight = 0, oldBottom = 0;
+				int newLeft = 0, newTop = 0, newRight = 0, newBottom = 0;
+				bool oldValid = cellRange(rectIter.value(), oldLeft, oldTop, oldRight, oldBottom);
+				bool newValid = cellRange(rect, newLeft, newTop, newRight, newBottom);
+
+				// Only touch the cells if the item moved to a different set of cells
+				if (oldValid != newValid || oldLeft != newLeft || oldTop != newTop ||
+					oldRight != newRight || oldBottom != newBottom)
+				{
+					removeFromCells(item, rectIter.value());
+					addToCells(item, rect);
+				}
+
+				rectIter.value() = rect;
+			}
+		}
+		else
+		{
+			mItemRects.insert(item, rect);
+			addToCells(item, rect);
+		}
+	}
+}
+
+void DrawingSceneIndex::clear()
+{
+	mCells.clear();
+	mLargeItems.clear();
+	mItemRects.clear();
+}
+
+//==================================================================================================
+
+bool DrawingSceneIndex::contains(DrawingItem* item) const
+{
+	return mItemRects.contains(item);
+}
+
+QRectF DrawingSceneIndex::itemRect(DrawingItem* item) const
+{
+	return mItemRects.value(item);
+}
+
+int DrawingSceneIndex::size() const
+{
+	return mItemRects.size();
+}
+
+//==================================================================================================
+
+QList<DrawingItem*> DrawingSceneIndex::items(const QRectF& sceneRect, qreal minimumSize) const
+{
+	QList<DrawingItem*> items;
+	QSet<DrawingItem*> foundItems;
+	QRectF rect = sceneRect.normalized();
+	int left = 0, top = 0, right = 0, bottom = 0;
+
+	if (cellRange(rect, left, top, right, bottom))
+	{
+		qint64 cellCount = (qint64)(right - left + 1) * (qint64)(bottom - top + 1);
+
+		if (cellCount <= mCells.size())
+		{
+			for(int row = top; row <= bottom; row++)
+			{
+				for(int column = left; column <= right; column++)
+				{
+					auto cellIter = mCells.find(cellKey(column, row));
+					if (cellIter != mCells.end())
+					{
+						const QList<DrawingItem*>& cellItems = cellIter.value();
+						for(auto itemIter = cellItems.begin(); itemIter != cellItems.end(); itemIter++)
+						{
+							QRectF itemRect = mItemRects.value(*itemIter);
+							if (isLargerThan(itemRect, minimumSize) && !foundItems.contains(*itemIter) &&
+								rectsIntersect(itemRect, rect))
+							{
+								foundItems.insert(*itemIter);
+								items.append(*itemIter);
+							}
+						}
+					}
+				}
+			}
+		}
+		else
+		{
+			// The query covers more cells than are populated, so just walk the populated cells
+			for(auto cellIter = mCells.begin(); cellIter != mCells.end(); cellIter++)
+			{
+				const QList<DrawingItem*>& cellItems = cellIter.value();
+				for(auto itemIter = cellItems.begin(); itemIter != cellItems.end(); itemIter++)
+				{
+					QRectF itemRect = mItemRects.value(*itemIter);
+					if (isLargerThan(itemRect, minimumSize) && !foundItems.contains(*itemIter) &&
+						rectsIntersect(itemRect, rect))
+					{
+						foundItems.insert(*itemIter);
+						items.append(*itemIter);
+					}
+				}
+			}
+		}
+	}
+
+	for(auto itemIter = mLargeItems.begin(); itemIter != mLargeItems.end(); itemIter++)
+	{
+		QRectF itemRect = mItemRects.value(*itemIter);
+		if (isLargerThan(itemRect, minimumSize) && rectsIntersect(itemRect, rect)) items.append(*itemIter);
+	}
+
+	return items;
+}
+
+QList<DrawingItem*> DrawingSceneIndex::items(const QPointF& scenePos) const
+{
+	return items(QRectF(scenePos, scenePos));
+}
+
+//==================================================================================================
+
+bool DrawingSceneIndex::cellRange(const QRectF& rect, int& left, int& top, int& right, int& bottom) const
+{
+	const qreal cellLimit = 1.0E9;
+
+	qreal cellLeft = qFloor(rect.left() / mCellSize);
+	qreal cellTop = qFloor(rect.top() / mCellSize);
+	qreal cellRight = qFloor(rect.right() / mCellSize);
+	qreal cellBottom = qFloor(rect.bottom() / mCellSize);
+
+	// Rects that are invalid or absurdly far from the origin are treated as large items
+	bool valid = (qAbs(cellLeft) < cellLimit && qAbs(cellTop) < cellLimit &&
+		qAbs(cellRight) < cellLimit && qAbs(cellBottom) < cellLimit);
+
+	if (valid)
+	{
+		left = (int)cellLeft;
+		top = (int)cellTop;
+		right = (int)cellRight;
+		bottom = (int)cellBottom;
+	}
+
+	return valid;
+}
+
+bool DrawingSceneIndex::isLargeRange(int left, int top, int right, int bottom) const
+{
+	const qint64 maximumCellsPerItem = 64;
+	return ((qint64)(right - left + 1) * (qint64)(bottom - top + 1) > maximumCellsPerItem);
+}
+
+//==================================================================================================
+
+void DrawingSceneIndex::addToCells(DrawingItem* item, const QRectF& rect)
+{
+	int left = 0, top = 0, right = 0, bottom = 0;
+
+	if (cellRange(rect, left, top, right, bottom) && !isLargeRange(left, top, right, bottom))
+	{
+		for(int row = top; row <= bottom; row++)
+		{
+			for(int column = left; column <= right; column++)
+				mCells[cellKey(column, row)].append(item);
+		}
+	}
+	else mLargeItems.append(item);
+}
+
+void DrawingSceneIndex::removeFromCells(DrawingItem* item, const QRectF& rect)
+{
+	int left = 0, top = 0, right = 0, bottom = 0;
+
+	if (cellRange(rect, left, top, right, bottom) && !isLargeRange(left, top, right, bottom))
+	{
+		for(int row = top; row <= bottom; row++)
+		{
+			for(int column = left; column <= right; column++)
+			{
+				auto cellIter = mCells.find(cellKey(column, row));
+				if (cellIter != mCells.end())
+				{
+					cellIter.value().removeOne(item);
+					if (cellIter.value().isEmpty()) mCells.erase(cellIter);
+				}
+			}
+		}
+	}
+	else mLargeItems.removeOne(item);
+}
+
+//==================================================================================================
+
+quint64 DrawingSceneIndex::cellKey(int column, int row)
+{
+	return ((quint64)(quint32)column << 32) | (quint64)(quint32)row;
+}
+
+bool DrawingSceneIndex::rectsIntersect(const QRectF& rect1, const QRectF& rect2)
+{
+	return (rect1.left() <= rect2.right() && rect2.left() <= rect1.right() &&
+		rect1.top() <= rect2.bottom() && rect2.top() <= rect1.bottom());
+}
+
+bool DrawingSceneIndex::isLargerThan(const QRectF& rect, qreal minimumSize)
+{
+	return (minimumSize <= 0 || rect.width() > minimumSize || rect.height() > minimumSize);
+}
@@ -0,0 +1,262 @@
+/* DrawingSceneOrder.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingSceneOrder.h"
+
+DrawingSceneOrder::DrawingSceneOrder()
+{
+	mRoot = nullptr;
+	mSeed = 2463534242u;
+}
+
+DrawingSceneOrder::~DrawingSceneOrder()
+{
+	clear();
+}
+
+//==================================================================================================
+
+void DrawingSceneOrder::insert(int index, DrawingItem* item)
+{
+	if (item && !mNodes.contains(item))
+	{
+		Node* node = new Node();
+		node->item = item;
+		node->left = nullptr;
+		node->right = nullptr;
+		node->parent = nullptr;
+		node->size = 1;
+		node->priority = nextPriority();
+
+		mNodes.insert(item, node);
+
+		Node* leftNodes = nullptr;
+		Node* rightNodes = nullptr;
+		split(mRoot, qBound(0, index, nodeSize(mRoot)), leftNodes, rightNodes);
+
+		mRoot = merge(merge(leftNodes, node), rightNodes);
+		mRoot->parent = nullptr;
+	}
+}
+
+void DrawingSceneOrder::append(DrawingItem* item)
+{
+	insert(size(), item);
+}
+
+void DrawingSceneOrder::remove(DrawingItem* item)
+{
+	int index = indexOf(item);
+
+	if (index >= 0)
+	{
+		Node* leftNodes = nullptr;
+		Node* middleNodes = nullptr;
+		Node* itemNode = nullptr;
+		Node* rightNodes = nullptr;
+
+		split(mRoot, index, leftNodes, middleNodes);
+		split(middleNodes, 1, itemNode, rightNodes);
+
+		mRoot = merge(leftNodes, rightNodes);
+		if (mRoot) mRoot->parent = nullptr;
+
+		delete mNodes.take(item);
+	}
+}
+
+void DrawingSceneOrder::move(DrawingItem* item, int index)
+{
+	if (contains(item))
+	{
+		remove(item);
+		insert(index, item);
+	}
+}
+
+void DrawingSceneOrder::clear()
+{
+	deleteNodes(mRoot);
+	mRoot = nullptr;
+	mNodes.clear();
+}
+
+//==================================================================================================
+
+bool DrawingSceneOrder::contains(DrawingItem* item) const
+{
+	return mNodes.contains(item);
+}
+
+int DrawingSceneOrder::indexOf(DrawingItem* item) const
+{
+	int index = -1;
+
+	Node* node = mNodes.value(item, nullptr);
+	if (node)
+	{
+		// Count the nodes before this one by walking up to the root
+		index = nodeSize(node->left);
+
+		for(; node->parent; node = node->parent)
+		{
+			if (node == node->parent->right) index += nodeSize(node->parent->left) + 1;
+		}
+	}
+
+	return index;
+}
+
+DrawingItem* DrawingSceneOrder::at(int index) const
+{
+	DrawingItem* item = nullptr;
+	Node* node = mRoot;
+
+	while (item == nullptr && node)
+	{
+		int leftSize = nodeSize(node->left);
+
+		if (index < leftSize) node = node->left;
+		else if (index == leftSize) item = node->item;
+		else
+		{
+			index -= leftSize + 1;
+			node = node->right;
+		}
+	}
+
+	return item;
+}
+
+int DrawingSceneOrder::size() const
+{
+	return nodeSize(mRoot);
+}
+
+QList<DrawingItem*> DrawingSceneOrder::toList() const
+{
+	QList<DrawingItem*> items;
+	items.reserve(size());
+	appendNodes(mRoot, items);
+	return items;
+}
+
+//==================================================================================================
+
+quint32 DrawingSceneOrder::nextPriority()
+{
+	// xorshift32; the priorities only need to be well distributed, not unpredictable
+	mSeed ^= mSeed << 13;
+	mSeed ^= mSeed >> 17;
+	mSeed ^= mSeed << 5;
+	return mSeed;
+}
+
+void DrawingSceneOrder::deleteNodes(Node* node)
+{
+	if (node)
+	{
+		deleteNodes(node->left);
+		deleteNodes(node->right);
+		delete node;
+	}
+}
+
+void DrawingSceneOrder::appendNodes(Node* node, QList<DrawingItem*>& items) const
+{
+	if (node)
+	{
+		appendNodes(node->left, items);
+		items.append(node->item);
+		appendNodes(node->right, items);
+	}
+}
+
+//==================================================================================================
+
+int DrawingSceneOrder::nodeSize(Node* node)
+{
+	return (node) ? node->size : 0;
+}
+
+void DrawingSceneOrder::updateNode(Node* node)
+{
+	node->size = nodeSize(node->left) + nodeSize(node->right) + 1;
+}
+
+DrawingSceneOrder::Node* DrawingSceneOrder::merge(Node* left, Node* right)
+{
+	Node* node = nullptr;
+
+	if (left == nullptr) node = right;
+	else if (right == nullptr) node = left;
+	else if (left->priority > right->priority)
+	{
+		left->right = merge(left->right, right);
+		left->right->parent = left;
+		updateNode(left);
+		node = left;
+	}
+	else
+	{
+		right->left = merge(left, right->left);
+		right->left->parent = right;
+		updateNode(right);
+		node = right;
+	}
+
+	return node;
+}
+
+void DrawingSceneOrder::split(Node* node, int index, Node*& left, Node*& right)
+{
+	// Splits the tree so that the first index items are in left and the rest are in right.  The
+	// parent pointers of the returned roots are set by the caller.
+	if (node == nullptr)
+	{
+		left = nullptr;
+		right = nullptr;
+	}
+	else if (nodeSize(node->left) < index)
+	{
+		Node* rightLeft = nullptr;
+		split(node->right, index - nodeSize(node->left) - 1, rightLeft, right);
+
+		node->right = rightLeft;
+		if (rightLeft) rightLeft->parent = node;
+		updateNode(node);
+
+		left = node;
+	}
+	else
+	{
+		Node* leftRight = nullptr;
+		split(node->left, index, left, leftRight);
+
+		node->left = leftRight;
+		if (leftRight) leftRight->parent = node;
+		updateNode(node);
+
+		right = node;
+	}
+
+	if (left) left->parent = nullptr;
+	if (right) right->parent = nullptr;
+}
@@ -0,0 +1,140 @@
+/* DrawingSceneSnapshot.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingSceneSnapshot.h"
+
+DrawingSceneSnapshot::DrawingSceneSnapshot(const QTransform& transform)
+{
+	mTransform = transform;
+	mMinimumRenderPenWidth = 0;
+	mMinimumTextSize = 0;
+}
+
+DrawingSceneSnapshot::~DrawingSceneSnapshot() { }
+
+//==================================================================================================
+
+QTransform DrawingSceneSnapshot::transform() const
+{
+	return mTransform;
+}
+
+void DrawingSceneSnapshot::setLevelOfDetail(qreal minimumRenderPenWidth, qreal minimumTextSize)
+{
+	mMinimumRenderPenWidth = minimumRenderPenWidth;
+	mMinimumTextSize = minimumTextSize;
+}
+
+//==================================================================================================
+
+DrawingDisplayList* DrawingSceneSnapshot::background()
+{
+	return &mBackground;
+}
+
+void DrawingSceneSnapshot::addItem(const DrawingDisplayList& displayList, const QTransform& transform,
+	const QRectF& sceneRect)
+{
+	Item item;
+	item.displayList = displayList;
+	item.transform = transform;
+
+	// Pad the rect to account for antialiasing and cosmetic pens
+	item.deviceRect = mTransform.mapRect(sceneRect).adjusted(-2, -2, 2, 2);
+
+	mItems.append(item);
+}
+
+void DrawingSceneSnapshot::addPlaceholder(const QRectF& rect, const QColor& color, const QTransform& transform)
+{
+	Item item;
+	item.transform = transform;
+	item.deviceRect = (transform * mTransform).mapRect(rect).adjusted(-2, -2, 2, 2);
+	item.placeholderRect = rect;
+	item.placeholderColor = color;
+
+	mItems.append(item);
+}
+
+int DrawingSceneSnapshot::itemCount() const
+{
+	return mItems.size();
+}
+
+//==================================================================================================
+
+void DrawingSceneSnapshot::draw(QPainter* painter, const QRectF& deviceRect) const
+{
+	QTransform deviceTransform = painter->transform();
+
+	mBackground.draw(painter);
+
+	painter->setTransform(mTransform, true);
+	QTransform sceneTransform = painter->transform();
+
+	// Consecutive items that record a single primitive with the same style are collected into a
+	// batch and drawn together, as in DrawingScene::drawItems()
+	DrawingDisplayListBatch batch;
+
+	for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
+	{
+		if (rectsIntersect(itemIter->deviceRect, deviceRect))
+		{
+			bool itemBatched = false;
+
+			if (itemIter->placeholderColor.isValid())
+			{
+				batch.draw(painter, mMinimumRenderPenWidth);
+
+				painter->setTransform(itemIter->transform * sceneTransform);
+				painter->fillRect(itemIter->placeholderRect, itemIter->placeholderColor);
+				painter->setTransform(sceneTransform);
+			}
+			else
+			{
+				itemBatched = batch.add(itemIter->displayList, itemIter->transform);
+				if (!itemBatched && !batch.isEmpty())
+				{
+					batch.draw(painter, mMinimumRenderPenWidth);
+					itemBatched = batch.add(itemIter->displayList, itemIter->transform);
+				}
+
+				if (!itemBatched)
+				{
+					painter->setTransform(itemIter->transform * sceneTransform);
+					itemIter->displayList.draw(painter, mMinimumRenderPenWidth, mMinimumTextSize);
+					painter->setTransform(sceneTransform);
+				}
+			}
+		}
+	}
+
+	batch.draw(painter, mMinimumRenderPenWidth);
+
+	painter->setTransform(deviceTransform);
+}
+
+//==================================================================================================
+
+bool DrawingSceneSnapshot::rectsIntersect(const QRectF& rect1, const QRectF& rect2)
+{
+	return (rect1.left() <= rect2.right() && rect2.left() <= rect1.right() &&
+		rect1.top() <= rect2.bottom() && rect2.top() <= rect1.bottom());
+}
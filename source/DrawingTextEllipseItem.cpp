@@ -119,6 +119,7 @@ QRectF DrawingTextEllipseItem::ellipse() const
 void DrawingTextEllipseItem::setCaption(const QString& caption)
 {
 	mCaption = caption;
+	prepareGeometryChange();
 }
 
 QString DrawingTextEllipseItem::caption() const
@@ -190,7 +191,7 @@ void DrawingTextEllipseItem::render(QPainter* painter)
 		QFont sceneFont = painter->font();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 		QFont font = style->font();
 		QBrush textBrush = style->textBrush();
@@ -201,15 +202,18 @@ void DrawingTextEllipseItem::render(QPainter* painter)
 		painter->drawEllipse(ellipse());
 
 		// Draw text
-		QFont painterFont = font;
-		if (painter->paintEngine()->paintDevice())
-			painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
-
-		QPen textPen(textBrush, 1, Qt::SolidLine);
-		painter->setBrush(Qt::transparent);
-		painter->setPen(textPen);
-		painter->setFont(painterFont);
-		painter->drawText(calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		if (isTextVisible(painter, font))
+		{
+			QFont painterFont = font;
+			if (painter->paintEngine()->paintDevice())
+				painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
+
+			QPen textPen(textBrush, 1, Qt::SolidLine);
+			painter->setBrush(Qt::transparent);
+			painter->setPen(textPen);
+			painter->setFont(painterFont);
+			mTextLayout.draw(painter, calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		}
 
 		painter->setBrush(sceneBrush);
 		painter->setPen(scenePen);
@@ -259,19 +263,10 @@ void DrawingTextEllipseItem::resizeEvent(DrawingItemPoint* itemPoint, const QPoi
 
 QRectF DrawingTextEllipseItem::calculateTextRect(const QString& caption, const QFont& font) const
 {
-	qreal textWidth = 0, textHeight = 0;
 	QRectF pointsRect = DrawingTextEllipseItem::ellipse();
 
-	QFontMetricsF fontMetrics(font);
-	QStringList lines = caption.split("\n");
-
-	for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
-	{
-		textWidth = qMax(textWidth, fontMetrics.width(*lineIter));
-		textHeight += fontMetrics.lineSpacing();
-	}
-
-	textHeight -= fontMetrics.leading();
+	QSizeF textSize = mTextLayout.size(caption, font);
+	qreal textWidth = textSize.width(), textHeight = textSize.height();
 
 	return QRectF(-textWidth / 2, -textHeight / 2, textWidth, textHeight).translated(pointsRect.center());
 }
@@ -76,6 +76,7 @@ DrawingItem* DrawingTextItem::copy() const
 void DrawingTextItem::setCaption(const QString& caption)
 {
 	mCaption = caption;
+	prepareGeometryChange();
 }
 
 QString DrawingTextItem::caption() const
@@ -127,15 +128,18 @@ void DrawingTextItem::render(QPainter* painter)
 		Qt::Alignment textAlignment = style->textAlignment();
 
 		// Draw text
-		QFont painterFont = font;
-		if (painter->paintEngine()->paintDevice())
-			painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
-
-		QPen textPen(textBrush, 1, Qt::SolidLine);
-		painter->setBrush(Qt::transparent);
-		painter->setPen(textPen);
-		painter->setFont(painterFont);
-		painter->drawText(calculateTextRect(mCaption, font, textAlignment), textAlignment, mCaption);
+		if (isTextVisible(painter, font))
+		{
+			QFont painterFont = font;
+			if (painter->paintEngine()->paintDevice())
+				painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
+
+			QPen textPen(textBrush, 1, Qt::SolidLine);
+			painter->setBrush(Qt::transparent);
+			painter->setPen(textPen);
+			painter->setFont(painterFont);
+			mTextLayout.draw(painter, calculateTextRect(mCaption, font, textAlignment), textAlignment, mCaption);
+		}
 
 		painter->setBrush(sceneBrush);
 		painter->setPen(scenePen);
@@ -148,18 +152,8 @@ void DrawingTextItem::render(QPainter* painter)
 QRectF DrawingTextItem::calculateTextRect(const QString& caption, const QFont& font,
 	Qt::Alignment textAlignment) const
 {
-	qreal textWidth = 0, textHeight = 0;
-
-	QFontMetricsF fontMetrics(font);
-	QStringList lines = caption.split("\n");
-
-	for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
-	{
-		textWidth = qMax(textWidth, fontMetrics.width(*lineIter));
-		textHeight += fontMetrics.lineSpacing();
-	}
-
-	textHeight -= fontMetrics.leading();
+	QSizeF textSize = mTextLayout.size(caption, font);
+	qreal textWidth = textSize.width(), textHeight = textSize.height();
 
 	// Determine text position
 	qreal textLeft = 0, textTop = 0;
@@ -0,0 +1,120 @@
+/* DrawingTextLayout.cpp
+ *
+ * Copyright (C) 2013-2017 Jason Allen
+ *
+ * This file is part of the jade library.
+ *
+ * jade is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * jade is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with jade.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "DrawingTextLayout.h"
+
+DrawingTextLayout::DrawingTextLayout()
+{
+	mSizeValid = false;
+
+	mDrawLineSpacing = 0;
+	mDrawLeading = 0;
+	mDrawValid = false;
+}
+
+DrawingTextLayout::~DrawingTextLayout() { }
+
+//==================================================================================================
+
+QSizeF DrawingTextLayout::size(const QString& caption, const QFont& font)
+{
+	QMutexLocker locker(&mMutex);
+
+	if (!mSizeValid || mSizeCaption != caption || mSizeFont != font)
+	{
+		qreal textWidth = 0, textHeight = 0;
+
+		QFontMetricsF fontMetrics(font);
+		QStringList lines = caption.split("\n");
+
+		for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
+		{
+			textWidth = qMax(textWidth, fontMetrics.width(*lineIter));
+			textHeight += fontMetrics.lineSpacing();
+		}
+
+		textHeight -= fontMetrics.leading();
+
+		mSizeCaption = caption;
+		mSizeFont = font;
+		mSize = QSizeF(textWidth, textHeight);
+		mSizeValid = true;
+	}
+
+	return mSize;
+}
+
+void DrawingTextLayout::draw(QPainter* painter, const QRectF& rect, Qt::Alignment alignment,
+	const QString& caption)
+{
+	QMutexLocker locker(&mMutex);
+
+	QFont font = painter->font();
+
+	if (!mDrawValid || mDrawCaption != caption || mDrawFont != font)
+	{
+		QFontMetricsF fontMetrics(font, painter->device());
+		QStringList lines = caption.split("\n");
+
+		mDrawLines.clear();
+		for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
+		{
+			QStaticText staticText(*lineIter);
+			staticText.setTextFormat(Qt::PlainText);
+			staticText.prepare(painter->transform(), font);
+			mDrawLines.append(staticText);
+		}
+
+		mDrawCaption = caption;
+		mDrawFont = font;
+		mDrawLineSpacing = fontMetrics.lineSpacing();
+		mDrawLeading = fontMetrics.leading();
+		mDrawValid = true;
+	}
+
+	// Determine the position of the first line
+	qreal textHeight = mDrawLines.size() * mDrawLineSpacing - mDrawLeading;
+	qreal textTop = rect.top();
+
+	if (alignment & Qt::AlignBottom) textTop = rect.bottom() - textHeight;
+	else if (alignment & Qt::AlignVCenter) textTop = rect.center().y() - textHeight / 2;
+
+	// Draw each line
+	for(auto lineIter = mDrawLines.begin(); lineIter != mDrawLines.end(); lineIter++)
+	{
+		qreal lineWidth = lineIter->size().width();
+		qreal lineLeft = rect.left();
+
+		if (alignment & Qt::AlignRight) lineLeft = rect.right() - lineWidth;
+		else if (alignment & Qt::AlignHCenter) lineLeft = rect.center().x() - lineWidth / 2;
+
+		painter->drawStaticText(QPointF(lineLeft, textTop), *lineIter);
+		textTop += mDrawLineSpacing;
+	}
+}
+
+void DrawingTextLayout::clear()
+{
+	QMutexLocker locker(&mMutex);
+
+	mSizeValid = false;
+	mDrawLines.clear();
+	mDrawValid = false;
+}
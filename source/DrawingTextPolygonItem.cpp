@@ -126,6 +126,7 @@ QPolygonF DrawingTextPolygonItem::polygon() const
 void DrawingTextPolygonItem::setCaption(const QString& caption)
 {
 	mCaption = caption;
+	prepareGeometryChange();
 }
 
 QString DrawingTextPolygonItem::caption() const
@@ -208,7 +209,7 @@ void DrawingTextPolygonItem::render(QPainter* painter)
 		QFont sceneFont = painter->font();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 		QFont font = style->font();
 		QBrush textBrush = style->textBrush();
@@ -219,15 +220,18 @@ void DrawingTextPolygonItem::render(QPainter* painter)
 		painter->drawPolygon(polygon());
 
 		// Draw text
-		QFont painterFont = font;
-		if (painter->paintEngine()->paintDevice())
-			painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
-
-		QPen textPen(textBrush, 1, Qt::SolidLine);
-		painter->setBrush(Qt::transparent);
-		painter->setPen(textPen);
-		painter->setFont(painterFont);
-		painter->drawText(calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		if (isTextVisible(painter, font))
+		{
+			QFont painterFont = font;
+			if (painter->paintEngine()->paintDevice())
+				painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
+
+			QPen textPen(textBrush, 1, Qt::SolidLine);
+			painter->setBrush(Qt::transparent);
+			painter->setPen(textPen);
+			painter->setFont(painterFont);
+			mTextLayout.draw(painter, calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		}
 
 		painter->setBrush(sceneBrush);
 		painter->setPen(scenePen);
@@ -312,8 +316,6 @@ qreal DrawingTextPolygonItem::distanceFromPointToLineSegment(const QPointF& poin
 
 QRectF DrawingTextPolygonItem::calculateTextRect(const QString& caption, const QFont& font) const
 {
-	qreal textWidth = 0, textHeight = 0;
-
 	QPolygonF polygon = DrawingTextPolygonItem::polygon();
 	//QPointF polygonCenter = polygon.boundingRect().center();
 	QPointF polygonCenter;
@@ -325,16 +327,8 @@ QRectF DrawingTextPolygonItem::calculateTextRect(const QString& caption, const Q
 	}
 	if (polygonCount > 0) polygonCenter = QPointF(polygonCenter.x() / polygonCount, polygonCenter.y() / polygonCount);
 
-	QFontMetricsF fontMetrics(font);
-	QStringList lines = caption.split("\n");
-
-	for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
-	{
-		textWidth = qMax(textWidth, fontMetrics.width(*lineIter));
-		textHeight += fontMetrics.lineSpacing();
-	}
-
-	textHeight -= fontMetrics.leading();
+	QSizeF textSize = mTextLayout.size(caption, font);
+	qreal textWidth = textSize.width(), textHeight = textSize.height();
 
 	return QRectF(-textWidth / 2, -textHeight / 2, textWidth, textHeight).translated(polygonCenter);
 }
@@ -124,6 +124,7 @@ void DrawingTextRectItem::setCornerRadii(qreal radiusX, qreal radiusY)
 {
 	mCornerRadiusX = radiusX;
 	mCornerRadiusY = radiusY;
+	prepareGeometryChange();
 }
 
 qreal DrawingTextRectItem::cornerRadiusX() const
@@ -141,6 +142,7 @@ qreal DrawingTextRectItem::cornerRadiusY() const
 void DrawingTextRectItem::setCaption(const QString& caption)
 {
 	mCaption = caption;
+	prepareGeometryChange();
 }
 
 QString DrawingTextRectItem::caption() const
@@ -212,7 +214,7 @@ void DrawingTextRectItem::render(QPainter* painter)
 		QFont sceneFont = painter->font();
 
 		DrawingItemStyle* style = DrawingItem::style();
-		QPen pen = style->pen();
+		QPen pen = renderPen(painter, style->pen());
 		QBrush brush = style->brush();
 		QFont font = style->font();
 		QBrush textBrush = style->textBrush();
@@ -223,15 +225,18 @@ void DrawingTextRectItem::render(QPainter* painter)
 		painter->drawRoundedRect(rect(), mCornerRadiusX, mCornerRadiusY);
 
 		// Draw text
-		QFont painterFont = font;
-		if (painter->paintEngine()->paintDevice())
-			painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
-
-		QPen textPen(textBrush, 1, Qt::SolidLine);
-		painter->setBrush(Qt::transparent);
-		painter->setPen(textPen);
-		painter->setFont(painterFont);
-		painter->drawText(calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		if (isTextVisible(painter, font))
+		{
+			QFont painterFont = font;
+			if (painter->paintEngine()->paintDevice())
+				painterFont.setPointSizeF(painterFont.pointSizeF() * 96.0 / painter->paintEngine()->paintDevice()->logicalDpiX());
+
+			QPen textPen(textBrush, 1, Qt::SolidLine);
+			painter->setBrush(Qt::transparent);
+			painter->setPen(textPen);
+			painter->setFont(painterFont);
+			mTextLayout.draw(painter, calculateTextRect(mCaption, font), Qt::AlignCenter, mCaption);
+		}
 
 		painter->setBrush(sceneBrush);
 		painter->setPen(scenePen);
@@ -282,19 +287,10 @@ void DrawingTextRectItem::resizeEvent(DrawingItemPoint* itemPoint, const QPointF
 
 QRectF DrawingTextRectItem::calculateTextRect(const QString& caption, const QFont& font) const
 {
-	qreal textWidth = 0, textHeight = 0;
 	QRectF pointsRect = DrawingTextRectItem::rect();
 
-	QFontMetricsF fontMetrics(font);
-	QStringList lines = caption.split("\n");
-
-	for(auto lineIter = lines.begin(); lineIter != lines.end(); lineIter++)
-	{
-		textWidth = qMax(textWidth, fontMetrics.width(*lineIter));
-		textHeight += fontMetrics.lineSpacing();
-	}
-
-	textHeight -= fontMetrics.leading();
+	QSizeF textSize = mTextLayout.size(caption, font);
+	qreal textWidth = textSize.width(), textHeight = textSize.height();
 
 	return QRectF(-textWidth / 2, -textHeight / 2, textWidth, textHeight).translated(pointsRect.center());
 }
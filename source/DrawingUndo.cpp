@@ -148,12 +148,7 @@ DrawingRemoveItemsCommand::DrawingRemoveItemsCommand(DrawingScene* scene,
 	mItems = items;
 	mUndone = true;
 	
-	if (mScene)
-	{
-		QList<DrawingItem*> drawingItems = mScene->items();
-		for(auto itemIter = mItems.begin(); itemIter != mItems.end(); itemIter++)
-			mItemIndex[*itemIter] = drawingItems.indexOf(*itemIter);
-	}
+	if (mScene) mItemIndex = mScene->itemIndices(mItems);
 }
 
 DrawingRemoveItemsCommand::~DrawingRemoveItemsCommand()
@@ -436,13 +431,14 @@ void DrawingFlipItemsVerticalCommand::undo()
 
 //==================================================================================================
 
-DrawingReorderItemsCommand::DrawingReorderItemsCommand(DrawingScene* scene,
-	const QList<DrawingItem*>& newItemOrder, QUndoCommand* parent)
+DrawingReorderItemsCommand::DrawingReorderItemsCommand(DrawingScene* scene, const QList<DrawingItem*>& items,
+	const QHash<DrawingItem*,int>& newIndices, QUndoCommand* parent)
 	: DrawingUndoCommand("Reorder Items", parent)
 {
 	mScene = scene;
-	mNewItemOrder = newItemOrder;
-	if (mScene) mOriginalItemOrder = mScene->items();
+	mItems = items;
+	mNewIndices = newIndices;
+	if (mScene) mOriginalIndices = mScene->itemIndices(mItems);
 }
 
 DrawingReorderItemsCommand::~DrawingReorderItemsCommand() { }
@@ -454,14 +450,14 @@ int DrawingReorderItemsCommand::id() const
 
 void DrawingReorderItemsCommand::redo()
 {
-	if (mScene) mScene->setItems(mNewItemOrder);
+	if (mScene) mScene->reorderItems(mItems, mNewIndices);
 	DrawingUndoCommand::redo();
 }
 
 void DrawingReorderItemsCommand::undo()
 {
 	DrawingUndoCommand::undo();
-	if (mScene) mScene->setItems(mOriginalItemOrder);
+	if (mScene) mScene->reorderItems(mItems, mOriginalIndices);
 }
 
 //==================================================================================================
@@ -25,6 +25,11 @@
 #include "DrawingItemPoint.h"
 #include "DrawingItemStyle.h"
 #include "DrawingUndo.h"
+#include "DrawingSceneSnapshot.h"
+#include <QtConcurrent>
+
+// Size of the tiles used to cache the rendered scene, in pixels
+static const int renderTileSize = 256;
 
 DrawingView::DrawingView() : QAbstractScrollArea()
 {
@@ -39,6 +44,12 @@ DrawingView::DrawingView() : QAbstractScrollArea()
 	mItemSelectionMode = Qt::ContainsItemBoundingRect;
 	mGrid = 50;
 
+	mMinimumTextSize = 4;
+	mMinimumDetailSize = 3;
+	mMinimumItemSize = 2;
+	mMinimumRenderPenWidth = 1;
+	mOverviewScale = 0.02;
+
 	mUndoStack.setUndoLimit(64);
 	connect(&mUndoStack, SIGNAL(cleanChanged(bool)), this, SIGNAL(cleanChanged(bool)));
 	connect(&mUndoStack, SIGNAL(canRedoChanged(bool)), this, SIGNAL(canRedoChanged(bool)));
@@ -62,10 +73,36 @@ DrawingView::DrawingView() : QAbstractScrollArea()
 
 	mPanTimer.setInterval(16);
 	connect(&mPanTimer, SIGNAL(timeout()), this, SLOT(mousePanEvent()));
+
+	mRenderTiles.setMaxCost(256);
+
+	mZoomTimer.setSingleShot(true);
+	mZoomTimer.setInterval(250);
+	connect(&mZoomTimer, SIGNAL(timeout()), this, SLOT(finishInteractiveZoom()));
+
+	mRenderTimeBudget = 16;
+	mRenderPassTileCount = 0;
+
+	mAsyncRenderStale = false;
+	mAsyncRenderReduced = false;
+	mAsyncRenderCancelled = 0;
+	connect(&mRenderWatcher, SIGNAL(finished()), this, SLOT(finishAsynchronousRender()));
+
+	mInteractionActive = false;
+	mInteractionTimer.setSingleShot(true);
+	mInteractionTimer.setInterval(250);
+	connect(&mInteractionTimer, SIGNAL(timeout()), this, SLOT(finishInteraction()));
+
+	// Every paint fills the exposed area with tiles, which lets scrollContentsBy() blit the
+	// previous frame instead of repainting the viewport
+	viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
 }
 
 DrawingView::~DrawingView()
 {
+	mAsyncRenderCancelled.store(1);
+	mRenderWatcher.waitForFinished();
+
 	mSelectedItems.clear();
 	mSelectedItemPoint = nullptr;
 
@@ -91,7 +128,14 @@ void DrawingView::setScene(DrawingScene* scene)
 		if (mFlags & ViewOwnsScene) delete mScene;
 	}
 
+	// The frame being rendered is for the previous scene, so there is no need to finish it
+	if (mRenderWatcher.isRunning()) mAsyncRenderCancelled.store(1);
+
 	mScene = scene;
+	mRenderTiles.clear();
+	mStaleRenderTiles.clear();
+	mAsyncRenderTiles.clear();
+	mReducedQualityTiles.clear();
 
 	if (mScene)
 	{
@@ -104,6 +148,12 @@ void DrawingView::setScene(DrawingScene* scene)
 		connect(mScene, SIGNAL(itemsPositionChanged(const QList<DrawingItem*>&)), this, SLOT(updateSelectionCenter()));
 		connect(mScene, SIGNAL(itemsGeometryChanged(const QList<DrawingItem*>&)), this, SLOT(updateSelectionCenter()));
 
+		connect(mScene, SIGNAL(itemsPositionChanged(const QList<DrawingItem*>&)), this, SLOT(invalidateItemRenderTiles(const QList<DrawingItem*>&)));
+		connect(mScene, SIGNAL(itemsTransformChanged(const QList<DrawingItem*>&)), this, SLOT(invalidateItemRenderTiles(const QList<DrawingItem*>&)));
+		connect(mScene, SIGNAL(itemsGeometryChanged(const QList<DrawingItem*>&)), this, SLOT(invalidateItemRenderTiles(const QList<DrawingItem*>&)));
+		connect(mScene, SIGNAL(itemsVisibilityChanged(const QList<DrawingItem*>&)), this, SLOT(invalidateItemRenderTiles(const QList<DrawingItem*>&)));
+		connect(mScene, SIGNAL(changed(const QList<QRectF>&)), this, SLOT(invalidateRenderTiles(const QList<QRectF>&)));
+
 		void numberOfItemsChanged(int itemCount);
 	}
 }
@@ -117,7 +167,24 @@ DrawingScene* DrawingView::scene() const
 
 void DrawingView::setFlags(Flags flags)
 {
+	bool asynchronousRendering = usesAsynchronousRendering();
+
 	mFlags = flags;
+
+	if (asynchronousRendering != usesAsynchronousRendering())
+	{
+		// The frame being rendered is discarded when it finishes
+		if (mRenderWatcher.isRunning()) mAsyncRenderCancelled.store(1);
+
+		// Stale tiles are only kept while asynchronous rendering is used; otherwise, any cached
+		// tile is drawn as if it was up to date
+		for(auto keyIter = mStaleRenderTiles.begin(); keyIter != mStaleRenderTiles.end(); keyIter++)
+			mRenderTiles.remove(*keyIter);
+		mStaleRenderTiles.clear();
+		mAsyncRenderTiles.clear();
+
+		viewport()->update();
+	}
 }
 
 DrawingView::Flags DrawingView::flags() const
@@ -171,6 +238,93 @@ QPointF DrawingView::roundToGrid(const QPointF& scenePos) const
 
 //==================================================================================================
 
+void DrawingView::setMinimumTextSize(qreal pixels)
+{
+	mMinimumTextSize = pixels;
+	resetCachedContent();
+}
+
+qreal DrawingView::minimumTextSize() const
+{
+	return mMinimumTextSize;
+}
+
+void DrawingView::setMinimumDetailSize(qreal pixels)
+{
+	mMinimumDetailSize = pixels;
+	resetCachedContent();
+}
+
+qreal DrawingView::minimumDetailSize() const
+{
+	return mMinimumDetailSize;
+}
+
+void DrawingView::setMinimumItemSize(qreal pixels)
+{
+	mMinimumItemSize = pixels;
+	resetCachedContent();
+}
+
+qreal DrawingView::minimumItemSize() const
+{
+	return mMinimumItemSize;
+}
+
+void DrawingView::setMinimumRenderPenWidth(qreal pixels)
+{
+	mMinimumRenderPenWidth = pixels;
+	resetCachedContent();
+}
+
+qreal DrawingView::minimumRenderPenWidth() const
+{
+	return mMinimumRenderPenWidth;
+}
+
+void DrawingView::setOverviewScale(qreal scale)
+{
+	mOverviewScale = scale;
+	resetCachedContent();
+}
+
+qreal DrawingView::overviewScale() const
+{
+	return mOverviewScale;
+}
+
+void DrawingView::setInteractiveZoomDelay(int msec)
+{
+	mZoomTimer.setInterval(msec);
+}
+
+int DrawingView::interactiveZoomDelay() const
+{
+	return mZoomTimer.interval();
+}
+
+void DrawingView::setRenderTimeBudget(int msec)
+{
+	mRenderTimeBudget = msec;
+}
+
+int DrawingView::renderTimeBudget() const
+{
+	return mRenderTimeBudget;
+}
+
+void DrawingView::setAdaptiveAntialiasingDelay(int msec)
+{
+	mInteractionTimer.setInterval(msec);
+}
+
+int DrawingView::adaptiveAntialiasingDelay() const
+{
+	return mInteractionTimer.interval();
+}
+
+//==================================================================================================
+
 void DrawingView::setUndoLimit(int undoLimit)
 {
 	mUndoStack.setUndoLimit(undoLimit);
@@ -317,6 +471,7 @@ void DrawingView::scaleBy(qreal scale)
 		QRectF scrollBarRect = scrollBarDefinedRect();
 
 		mScale *= scale;
+		beginInteraction();
 
 		recalculateContentSize(scrollBarRect);
 
@@ -429,6 +584,48 @@ void DrawingView::render(QPainter* painter)
 	if (mScene) mScene->render(painter);
 }
 
+QImage DrawingView::renderImage(const QRectF& sceneRect, const QSize& imageSize)
+{
+	QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+
+	if (mScene && !sceneRect.isEmpty() && !imageSize.isEmpty())
+	{
+		QTransform transform;
+		transform.scale(imageSize.width() / sceneRect.width(), imageSize.height() / sceneRect.height());
+		transform.translate(-sceneRect.left(), -sceneRect.top());
+
+		mScene->processChanges();
+
+		QVector<RenderTile> tiles;
+		for(int y = 0; y < imageSize.height(); y += renderTileSize)
+		{
+			for(int x = 0; x < imageSize.width(); x += renderTileSize)
+			{
+				RenderTile tile;
+				tile.rect = QRect(x, y, qMin(renderTileSize, imageSize.width() - x),
+					qMin(renderTileSize, imageSize.height() - y));
+				tiles.append(tile);
+			}
+		}
+
+		renderTiles(tiles, transform, Qt::transparent, QPainter::Antialiasing | QPainter::TextAntialiasing);
+
+		QPainter painter(&image);
+		painter.setCompositionMode(QPainter::CompositionMode_Source);
+		for(auto tileIter = tiles.begin(); tileIter != tiles.end(); tileIter++)
+			painter.drawImage(tileIter->rect.topLeft(), tileIter->image);
+	}
+
+	return image;
+}
+
+void DrawingView::resetCachedContent()
+{
+	invalidateRenderTiles(QList<QRectF>());
+	viewport()->update();
+}
+
 //==================================================================================================
 
 void DrawingView::zoomIn()
@@ -936,33 +1133,38 @@ void DrawingView::bringForward()
 {
 	if (mMode == DefaultMode && mScene && !mSelectedItems.isEmpty())
 	{
-		QList<DrawingItem*> itemsToReorder;
-
-		for(auto itemIter = mSelectedItems.begin(); itemIter != mSelectedItems.end(); itemIter++)
-		{
-			if ((*itemIter)->parent() == nullptr) itemsToReorder.append(*itemIter);
-		}
+		QHash<DrawingItem*,int> itemIndex;
+		QList<DrawingItem*> itemsToReorder = selectedItemsInOrder(itemIndex);
 
 		if (!itemsToReorder.isEmpty())
 		{
-			QList<DrawingItem*> itemsOrdered = mScene->mItems;
-			DrawingItem* item;
-			int itemIndex;
+			QList<DrawingItem*> itemsToMove;
+			QHash<DrawingItem*,int> newItemIndex;
+			int maximumIndex = mScene->mItemOrder.size() - 1;
+			int newIndex;
 
-			while (!itemsToReorder.empty())
+			// Move each item up one position, starting from the topmost item, without letting it
+			// pass another selected item
+			auto itemIter = itemsToReorder.end();
+			while (itemIter != itemsToReorder.begin())
 			{
-				item = itemsToReorder.takeLast();
+				itemIter--;
 
-				itemIndex = itemsOrdered.indexOf(item);
-				if (itemIndex >= 0)
+				newIndex = qMin(itemIndex[*itemIter] + 1, maximumIndex);
+				if (newIndex != itemIndex[*itemIter])
 				{
-					itemsOrdered.removeAll(item);
-					itemsOrdered.insert(itemIndex + 1, item);
+					itemsToMove.append(*itemIter);
+					newItemIndex.insert(*itemIter, newIndex);
 				}
+
+				maximumIndex = newIndex - 1;
 			}
 
-			reorderItemsCommand(itemsOrdered);
-			viewport()->update();
+			if (!itemsToMove.isEmpty())
+			{
+				reorderItemsCommand(itemsToMove, newItemIndex);
+				viewport()->update();
+			}
 		}
 	}
 }
@@ -971,33 +1173,35 @@ void DrawingView::sendBackward()
 {
 	if (mMode == DefaultMode && mScene && !mSelectedItems.isEmpty())
 	{
-		QList<DrawingItem*> itemsToReorder;
-
-		for(auto itemIter = mSelectedItems.begin(); itemIter != mSelectedItems.end(); itemIter++)
-		{
-			if ((*itemIter)->parent() == nullptr) itemsToReorder.append(*itemIter);
-		}
+		QHash<DrawingItem*,int> itemIndex;
+		QList<DrawingItem*> itemsToReorder = selectedItemsInOrder(itemIndex);
 
 		if (!itemsToReorder.isEmpty())
 		{
-			QList<DrawingItem*> itemsOrdered = mScene->mItems;
-			DrawingItem* item;
-			int itemIndex;
+			QList<DrawingItem*> itemsToMove;
+			QHash<DrawingItem*,int> newItemIndex;
+			int minimumIndex = 0;
+			int newIndex;
 
-			while (!itemsToReorder.empty())
+			// Move each item down one position, starting from the bottommost item, without letting
+			// it pass another selected item
+			for(auto itemIter = itemsToReorder.begin(); itemIter != itemsToReorder.end(); itemIter++)
 			{
-				item = itemsToReorder.takeLast();
-
-				itemIndex = itemsOrdered.indexOf(item);
-				if (itemIndex >= 0)
+				newIndex = qMax(itemIndex[*itemIter] - 1, minimumIndex);
+				if (newIndex != itemIndex[*itemIter])
 				{
-					itemsOrdered.removeAll(item);
-					itemsOrdered.insert(itemIndex - 1, item);
+					itemsToMove.append(*itemIter);
+					newItemIndex.insert(*itemIter, newIndex);
 				}
+
+				minimumIndex = newIndex + 1;
 			}
 
-			reorderItemsCommand(itemsOrdered);
-			viewport()->update();
+			if (!itemsToMove.isEmpty())
+			{
+				reorderItemsCommand(itemsToMove, newItemIndex);
+				viewport()->update();
+			}
 		}
 	}
 }
@@ -1006,33 +1210,29 @@ void DrawingView::bringToFront()
 {
 	if (mMode == DefaultMode && mScene && !mSelectedItems.isEmpty())
 	{
-		QList<DrawingItem*> itemsToReorder;
-
-		for(auto itemIter = mSelectedItems.begin(); itemIter != mSelectedItems.end(); itemIter++)
-		{
-			if ((*itemIter)->parent() == nullptr) itemsToReorder.append(*itemIter);
-		}
+		QHash<DrawingItem*,int> itemIndex;
+		QList<DrawingItem*> itemsToReorder = selectedItemsInOrder(itemIndex);
 
 		if (!itemsToReorder.isEmpty())
 		{
-			QList<DrawingItem*> itemsOrdered = mScene->mItems;
-			DrawingItem* item;
-			int itemIndex;
+			QList<DrawingItem*> itemsToMove;
+			QHash<DrawingItem*,int> newItemIndex;
+			int newIndex = mScene->mItemOrder.size() - itemsToReorder.size();
 
-			while (!itemsToReorder.empty())
+			for(auto itemIter = itemsToReorder.begin(); itemIter != itemsToReorder.end(); itemIter++, newIndex++)
 			{
-				item = itemsToReorder.takeLast();
-
-				itemIndex = itemsOrdered.indexOf(item);
-				if (itemIndex >= 0)
+				if (newIndex != itemIndex[*itemIter])
 				{
-					itemsOrdered.removeAll(item);
-					itemsOrdered.append(item);
+					itemsToMove.append(*itemIter);
+					newItemIndex.insert(*itemIter, newIndex);
 				}
 			}
 
-			reorderItemsCommand(itemsOrdered);
-			viewport()->update();
+			if (!itemsToMove.isEmpty())
+			{
+				reorderItemsCommand(itemsToMove, newItemIndex);
+				viewport()->update();
+			}
 		}
 	}
 }
@@ -1041,33 +1241,29 @@ void DrawingView::sendToBack()
 {
 	if (mMode == DefaultMode && mScene && !mSelectedItems.isEmpty())
 	{
-		QList<DrawingItem*> itemsToReorder;
-
-		for(auto itemIter = mSelectedItems.begin(); itemIter != mSelectedItems.end(); itemIter++)
-		{
-			if ((*itemIter)->parent() == nullptr) itemsToReorder.append(*itemIter);
-		}
+		QHash<DrawingItem*,int> itemIndex;
+		QList<DrawingItem*> itemsToReorder = selectedItemsInOrder(itemIndex);
 
 		if (!itemsToReorder.isEmpty())
 		{
-			QList<DrawingItem*> itemsOrdered = mScene->mItems;
-			DrawingItem* item;
-			int itemIndex;
+			QList<DrawingItem*> itemsToMove;
+			QHash<DrawingItem*,int> newItemIndex;
+			int newIndex = 0;
 
-			while (!itemsToReorder.empty())
+			for(auto itemIter = itemsToReorder.begin(); itemIter != itemsToReorder.end(); itemIter++, newIndex++)
 			{
-				item = itemsToReorder.takeLast();
-
-				itemIndex = itemsOrdered.indexOf(item);
-				if (itemIndex >= 0)
+				if (newIndex != itemIndex[*itemIter])
 				{
-					itemsOrdered.removeAll(item);
-					itemsOrdered.prepend(item);
+					itemsToMove.append(*itemIter);
+					newItemIndex.insert(*itemIter, newIndex);
 				}
 			}
 
-			reorderItemsCommand(itemsOrdered);
-			viewport()->update();
+			if (!itemsToMove.isEmpty())
+			{
+				reorderItemsCommand(itemsToMove, newItemIndex);
+				viewport()->update();
+			}
 		}
 	}
 }
@@ -1185,25 +1381,194 @@ void DrawingView::ungroup()
 
 void DrawingView::paintEvent(QPaintEvent* event)
 {
-	QImage image(viewport()->width(), viewport()->height(), QImage::Format_RGB32);
-	image.fill(palette().brush(QPalette::Window).color());
+	// Bring the tiles up to date with any changes to the scene or zoom level.  With the
+	// InteractiveZoom flag set, the existing tiles are kept and scaled to the new zoom level until
+	// the zoom timer expires; each new zoom level restarts the timer.
+	bool zoomPreview = false;
 
-	// Render scene
-	QPainter painter(&image);
+	if (mScene) mScene->processChanges();
+	if (mRenderTilesTransform != mViewportTransform)
+	{
+		if ((mFlags & InteractiveZoom) && !mRenderTiles.isEmpty())
+		{
+			if (mZoomPreviewTransform != mViewportTransform)
+			{
+				mZoomPreviewTransform = mViewportTransform;
+				mZoomTimer.start();
+			}
 
-	painter.translate(-horizontalScrollBar()->value(), -verticalScrollBar()->value());
-	painter.setTransform(mViewportTransform, true);
-	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+			zoomPreview = true;
+		}
+		else if (usesAsynchronousRendering() && !mRenderTiles.isEmpty())
+		{
+			// Keep showing the previous frame until the new one has been rendered
+			zoomPreview = true;
+		}
+		else
+		{
+			mRenderTiles.clear();
+			mStaleRenderTiles.clear();
+			mReducedQualityTiles.clear();
+			mRenderTilesTransform = mViewportTransform;
+		}
+	}
 
-	render(&painter);
+	// Tiles are aligned to the content area, so they remain valid as the view is scrolled
+	QPoint scrollOffset(horizontalScrollBar()->value(), verticalScrollBar()->value());
 
-	painter.end();
+	// Keep at least a few screens' worth of tiles so that scrolling back and forth is cheap
+	int visibleTileCount = (viewport()->width() / renderTileSize + 2) * (viewport()->height() / renderTileSize + 2);
+	if (mRenderTiles.maxCost() < 3 * visibleTileCount) mRenderTiles.setMaxCost(3 * visibleTileCount);
 
-	// Render scene image on to widget
 	QPainter widgetPainter(viewport());
-	widgetPainter.drawImage(0, 0, image);
 
-	Q_UNUSED(event);
+	if (zoomPreview)
+	{
+		drawZoomPreview(&widgetPainter, scrollOffset);
+
+		if (usesAsynchronousRendering() && !mZoomTimer.isActive())
+			startAsynchronousRender(viewport()->rect().translated(scrollOffset));
+	}
+	else
+	{
+		// Draw the scene content layer from the cached tiles, then render any tiles that are
+		// missing.  After scrolling, the exposed region is a strip along one or two edges of the
+		// viewport, so each rect of the region is handled separately rather than using its
+		// bounding rect.
+		QVector<RenderTile> tilesToRender;
+		QSet<quint64> exposedTiles;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+		const QRegion& exposedRects = event->region();
+#else
+		QVector<QRect> exposedRects = event->region().rects();
+#endif
+
+		for(auto rectIter = exposedRects.begin(); rectIter != exposedRects.end(); rectIter++)
+		{
+			QRect exposedRect = rectIter->translated(scrollOffset);
+
+			int leftColumn = qFloor((qreal)exposedRect.left() / renderTileSize);
+			int rightColumn = qFloor((qreal)exposedRect.right() / renderTileSize);
+			int topRow = qFloor((qreal)exposedRect.top() / renderTileSize);
+			int bottomRow = qFloor((qreal)exposedRect.bottom() / renderTileSize);
+
+			for(int row = topRow; row <= bottomRow; row++)
+			{
+				for(int column = leftColumn; column <= rightColumn; column++)
+				{
+					quint64 tileKey = renderTileKey(column, row);
+
+					if (!exposedTiles.contains(tileKey))
+					{
+						QImage* tileImage = mRenderTiles.object(tileKey);
+						if (tileImage)
+							widgetPainter.drawImage(QPoint(column * renderTileSize, row * renderTileSize) - scrollOffset, *tileImage);
+						else
+						{
+							RenderTile tile;
+							tile.rect = QRect(column * renderTileSize, row * renderTileSize, renderTileSize, renderTileSize);
+							tilesToRender.append(tile);
+						}
+
+						exposedTiles.insert(tileKey);
+					}
+				}
+			}
+		}
+
+		QColor fillColor = palette().brush(QPalette::Window).color();
+		QPainter::RenderHints renderHints = renderQualityHints();
+		int renderedTileCount = tilesToRender.size();
+
+		if (usesAsynchronousRendering() && (!tilesToRender.isEmpty() || exposedTiles.intersects(mStaleRenderTiles)))
+		{
+			// Leave the missing tiles empty until the background thread has rendered them.  Stale
+			// tiles are still drawn above, and are replaced when their new images are ready.
+			for(auto tileIter = tilesToRender.begin(); tileIter != tilesToRender.end(); tileIter++)
+				widgetPainter.fillRect(tileIter->rect.translated(-scrollOffset), fillColor);
+
+			startAsynchronousRender(viewport()->rect().translated(scrollOffset));
+			tilesToRender.clear();
+			renderedTileCount = 0;
+		}
+
+		if (!tilesToRender.isEmpty() && !mRenderPassTimer.isValid())
+		{
+			mRenderPassTimer.start();
+			mRenderPassTileCount = 0;
+		}
+
+		if ((mFlags & ProgressiveRendering) && !tilesToRender.isEmpty())
+		{
+			// Render the tiles nearest the mouse cursor (or the center of the viewport) first
+			QPoint focusPos = viewport()->mapFromGlobal(QCursor::pos());
+			if (!viewport()->rect().contains(focusPos)) focusPos = viewport()->rect().center();
+			focusPos += scrollOffset;
+
+			std::sort(tilesToRender.begin(), tilesToRender.end(), [&focusPos](const RenderTile& tile1, const RenderTile& tile2) {
+				return ((tile1.rect.center() - focusPos).manhattanLength() <
+					(tile2.rect.center() - focusPos).manhattanLength()); });
+
+			// Render one tile per thread at a time until the time budget is used up
+			int groupSize = (mFlags & SingleThreadedRendering) ? 1 : qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+			QElapsedTimer budgetTimer;
+			budgetTimer.start();
+
+			renderedTileCount = 0;
+			while (renderedTileCount < tilesToRender.size() &&
+				(renderedTileCount == 0 || budgetTimer.elapsed() < mRenderTimeBudget))
+			{
+				QVector<RenderTile> tileGroup = tilesToRender.mid(renderedTileCount, groupSize);
+				renderTiles(tileGroup, mViewportTransform, fillColor, renderHints);
+
+				for(int i = 0; i < tileGroup.size(); i++)
+					tilesToRender[renderedTileCount + i].image = tileGroup[i].image;
+				renderedTileCount += tileGroup.size();
+			}
+
+			// Leave the remaining tiles empty and render them in a later paint event
+			for(auto tileIter = tilesToRender.begin() + renderedTileCount; tileIter != tilesToRender.end(); tileIter++)
+			{
+				QRect tileRect = tileIter->rect.translated(-scrollOffset);
+				widgetPainter.fillRect(tileRect, fillColor);
+				mPendingRenderRegion += tileRect;
+			}
+
+			if (renderedTileCount < tilesToRender.size())
+				QMetaObject::invokeMethod(this, "continueProgressiveRendering", Qt::QueuedConnection);
+		}
+		else renderTiles(tilesToRender, mViewportTransform, fillColor, renderHints);
+
+		for(auto tileIter = tilesToRender.begin(); tileIter != tilesToRender.begin() + renderedTileCount; tileIter++)
+		{
+			quint64 tileKey = renderTileKey(tileIter->rect.left() / renderTileSize,
+				tileIter->rect.top() / renderTileSize);
+
+			widgetPainter.drawImage(tileIter->rect.topLeft() - scrollOffset, tileIter->image);
+			mRenderTiles.insert(tileKey, new QImage(tileIter->image));
+
+			// Remember which tiles need to be rendered again once the interaction is finished
+			if (mInteractionActive) mReducedQualityTiles.insert(tileKey);
+			else mReducedQualityTiles.remove(tileKey);
+		}
+
+		// Report the time taken once every tile in the visible area has been rendered
+		mRenderPassTileCount += renderedTileCount;
+		if (mRenderPassTimer.isValid() && mPendingRenderRegion.isEmpty() && !mRenderWatcher.isRunning())
+		{
+			emit renderingFinished(mRenderPassTileCount, (int)mRenderPassTimer.elapsed());
+			mRenderPassTimer.invalidate();
+		}
+	}
+
+	// Draw the interaction overlay on top of the tiles; it is redrawn on every paint, so changes
+	// that only affect the overlay never render any scene items
+	widgetPainter.translate(-scrollOffset);
+	widgetPainter.setTransform(mViewportTransform, true);
+	widgetPainter.setRenderHints(renderQualityHints());
+	widgetPainter.setClipRect(mapToScene(event->rect().adjusted(-1, -1, 1, 1)).normalized());
+
+	drawForeground(&widgetPainter);
 }
 
 void DrawingView::resizeEvent(QResizeEvent* event)
@@ -1212,6 +1577,21 @@ void DrawingView::resizeEvent(QResizeEvent* event)
 	recalculateContentSize();
 }
 
+void DrawingView::scrollContentsBy(int dx, int dy)
+{
+	beginInteraction();
+
+	// The previous frame can only be reused if the scene is drawn at the same zoom level.  The
+	// rubber band stays in place in the viewport as the scene scrolls underneath it.
+	if (mRenderTilesTransform == mViewportTransform && !mRubberBandRect.isValid() &&
+		mPendingRenderRegion.isEmpty())
+	{
+		viewport()->scroll(dx, dy);
+	}
+	else
+		viewport()->update();
+}
+
 //==================================================================================================
 
 void DrawingView::mousePressEvent(QMouseEvent* event)
@@ -1412,6 +1792,7 @@ void DrawingView::mouseMoveEvent(QMouseEvent* event)
 
 	if (mPanTimer.isActive()) mPanCurrentPos = event->pos();
 
+	if ((event->buttons() != Qt::NoButton && mDragged) || mMode == PlaceMode) beginInteraction();
 	if (event->buttons() != Qt::NoButton || mMode == PlaceMode) viewport()->update();
 }
 
@@ -1575,6 +1956,9 @@ void DrawingView::mouseReleaseEvent(QMouseEvent* event)
 		viewport()->update();
 		emit mouseInfoChanged("");
 	}
+
+	// Items in place mode keep following the mouse, so that interaction only ends when idle
+	if (mMode != PlaceMode) finishInteraction();
 }
 
 void DrawingView::mouseDoubleClickEvent(QMouseEvent* event)
@@ -1652,7 +2036,13 @@ void DrawingView::drawBackground(QPainter* painter)
 
 void DrawingView::drawItems(QPainter* painter)
 {
-	if (mScene) mScene->drawItems(painter);
+	if (mScene)
+	{
+		qreal scale = qSqrt(qAbs(painter->worldTransform().determinant()));
+
+		if (scale < mOverviewScale) mScene->drawOverview(painter);
+		else mScene->drawItems(painter);
+	}
 }
 
 void DrawingView::drawForeground(QPainter* painter)
@@ -1710,6 +2100,7 @@ void DrawingView::drawForeground(QPainter* painter)
 
 		// Draw hotpoints
 		QList<DrawingItem*> items = mNewItems + mSelectedItems;
+		QList<DrawingItem*> sceneItems = mScene->items();
 
 		painter->save();
 
@@ -1724,7 +2115,7 @@ void DrawingView::drawForeground(QPainter* painter)
 
 			for(auto pointIter = itemPoints.begin(); pointIter != itemPoints.end(); pointIter++)
 			{
-				for(auto otherItemIter = mScene->mItems.begin(); otherItemIter != mScene->mItems.end(); otherItemIter++)
+				for(auto otherItemIter = sceneItems.begin(); otherItemIter != sceneItems.end(); otherItemIter++)
 				{
 					if ((*itemIter)->parent() == nullptr && (*itemIter) != (*otherItemIter))
 					{
@@ -1854,6 +2245,176 @@ void DrawingView::mousePanEvent()
 	}
 }
 
+void DrawingView::finishInteractiveZoom()
+{
+	// With asynchronous rendering, the zoom preview stays up until the new frame is ready
+	if (usesAsynchronousRendering()) viewport()->update();
+	else if (mRenderTilesTransform != mViewportTransform)
+	{
+		mRenderTiles.clear();
+		mReducedQualityTiles.clear();
+		mRenderTilesTransform = mViewportTransform;
+		viewport()->update();
+	}
+}
+
+void DrawingView::continueProgressiveRendering()
+{
+	// Any tiles that still do not fit within the time budget are added back to the pending region
+	viewport()->update(mPendingRenderRegion);
+	mPendingRenderRegion = QRegion();
+}
+
+void DrawingView::finishAsynchronousRender()
+{
+	QVector<RenderTile> tiles = mRenderWatcher.result();
+
+	// Tiles rendered at a zoom level that is no longer current, or for a scene that is no longer
+	// shown, are discarded.  A cancelled frame may be missing some of its tiles, so it is
+	// discarded as well, and its tiles are rendered again by the next frame.
+	if (mAsyncRenderCancelled.load())
+		mStaleRenderTiles.unite(mAsyncRenderTiles);
+	else if (mAsyncRenderTransform == mViewportTransform && !mAsyncRenderTiles.isEmpty())
+	{
+		if (mRenderTilesTransform != mAsyncRenderTransform)
+		{
+			mRenderTiles.clear();
+			mStaleRenderTiles.clear();
+			mReducedQualityTiles.clear();
+			mRenderTilesTransform = mAsyncRenderTransform;
+
+			// Changes to the scene while the frame was rendered were mapped to the old tiles, so
+			// the whole frame has to be rendered again
+			if (mAsyncRenderStale) mStaleRenderTiles = mAsyncRenderTiles;
+		}
+
+		for(auto tileIter = tiles.begin(); tileIter != tiles.end(); tileIter++)
+		{
+			quint64 tileKey = renderTileKey(tileIter->rect.left() / renderTileSize,
+				tileIter->rect.top() / renderTileSize);
+
+			mRenderTiles.insert(tileKey, new QImage(tileIter->image));
+
+			// If the interaction finished while the frame was rendered without antialiasing, the
+			// tile is rendered again right away
+			if (!mAsyncRenderReduced) mReducedQualityTiles.remove(tileKey);
+			else if (mInteractionActive) mReducedQualityTiles.insert(tileKey);
+			else mStaleRenderTiles.insert(tileKey);
+		}
+
+		mRenderPassTileCount += tiles.size();
+		if (mRenderPassTimer.isValid())
+		{
+			emit renderingFinished(mRenderPassTileCount, (int)mRenderPassTimer.elapsed());
+			mRenderPassTimer.invalidate();
+		}
+	}
+
+	mAsyncRenderTiles.clear();
+
+	// Show the new frame.  Any tiles that were changed while the frame was being rendered are
+	// still stale, so this also starts the next frame if needed.
+	viewport()->update();
+}
+
+void DrawingView::finishInteraction()
+{
+	mInteractionTimer.stop();
+
+	if (mInteractionActive)
+	{
+		mInteractionActive = false;
+
+		for(auto keyIter = mReducedQualityTiles.begin(); keyIter != mReducedQualityTiles.end(); keyIter++)
+			invalidateRenderTile(*keyIter);
+		mReducedQualityTiles.clear();
+
+		viewport()->update();
+	}
+}
+
+void DrawingView::invalidateRenderTiles(const QList<QRectF>& sceneRects)
+{
+	if (mRenderWatcher.isRunning() && mAsyncRenderTransform != mRenderTilesTransform)
+		mAsyncRenderStale = true;
+
+	if (sceneRects.isEmpty())
+	{
+		if (usesAsynchronousRendering())
+		{
+			QList<quint64> tileKeys = mRenderTiles.keys() + mAsyncRenderTiles.toList();
+			for(auto keyIter = tileKeys.begin(); keyIter != tileKeys.end(); keyIter++)
+				mStaleRenderTiles.insert(*keyIter);
+		}
+		else
+		{
+			mRenderTiles.clear();
+			mReducedQualityTiles.clear();
+		}
+	}
+	else
+	{
+		QList<quint64> tileKeys = mRenderTiles.keys() + mAsyncRenderTiles.toList();
+
+		for(auto rectIter = sceneRects.begin(); rectIter != sceneRects.end(); rectIter++)
+		{
+			// Pad the rect to account for antialiasing and cosmetic pens
+			QRect contentRect = mRenderTilesTransform.mapRect(*rectIter).toAlignedRect().adjusted(-2, -2, 2, 2);
+
+			int leftColumn = qFloor((qreal)contentRect.left() / renderTileSize);
+			int rightColumn = qFloor((qreal)contentRect.right() / renderTileSize);
+			int topRow = qFloor((qreal)contentRect.top() / renderTileSize);
+			int bottomRow = qFloor((qreal)contentRect.bottom() / renderTileSize);
+
+			if ((qint64)(rightColumn - leftColumn + 1) * (qint64)(bottomRow - topRow + 1) <= tileKeys.size())
+			{
+				for(int row = topRow; row <= bottomRow; row++)
+				{
+					for(int column = leftColumn; column <= rightColumn; column++)
+						invalidateRenderTile(renderTileKey(column, row));
+				}
+			}
+			else
+			{
+				// The rect covers more tiles than are cached, so just check each cached tile
+				for(auto keyIter = tileKeys.begin(); keyIter != tileKeys.end(); keyIter++)
+				{
+					int column = (qint32)(*keyIter >> 32);
+					int row = (qint32)(*keyIter & 0xFFFFFFFF);
+
+					if (leftColumn <= column && column <= rightColumn && topRow <= row && row <= bottomRow)
+						invalidateRenderTile(*keyIter);
+				}
+			}
+		}
+	}
+}
+
+void DrawingView::invalidateItemRenderTiles(const QList<DrawingItem*>& items)
+{
+	// Invalidate both the area that each item (and each of its children) was indexed with and
+	// its new area right away.  The scene also reports these areas through changed() once it
+	// re-indexes the items, but by then the item's old area is no longer known to the view.
+	QList<DrawingItem*> changedItems = items;
+	QList<QRectF> sceneRects;
+
+	for(int itemIndex = 0; itemIndex < changedItems.size(); itemIndex++)
+	{
+		DrawingItem* item = changedItems[itemIndex];
+
+		if (mScene && mScene->mItemIndex.contains(item)) sceneRects.append(mScene->mItemIndex.itemRect(item));
+		sceneRects.append(item->sceneBoundingRect());
+		changedItems.append(item->mChildren);
+	}
+
+	// An empty list would invalidate the entire scene
+	if (!sceneRects.isEmpty())
+	{
+		invalidateRenderTiles(sceneRects);
+		viewport()->update();
+	}
+}
+
 //==================================================================================================
 
 void DrawingView::addItemsCommand(const QList<DrawingItem*>& items, bool place, QUndoCommand* command)
@@ -1961,12 +2522,13 @@ void DrawingView::flipItemsVerticalCommand(const QList<DrawingItem*>& items, con
 	if (!command) mUndoStack.push(flipCommand);
 }
 
-void DrawingView::reorderItemsCommand(const QList<DrawingItem*>& itemsOrdered, QUndoCommand* command)
+void DrawingView::reorderItemsCommand(const QList<DrawingItem*>& items,
+	const QHash<DrawingItem*,int>& newIndex, QUndoCommand* command)
 {
-	DrawingReorderItemsCommand* selectCommand =
-		new DrawingReorderItemsCommand(mScene, itemsOrdered, command);
+	DrawingReorderItemsCommand* reorderCommand =
+		new DrawingReorderItemsCommand(mScene, items, newIndex, command);
 
-	if (!command) mUndoStack.push(selectCommand);
+	if (!command) mUndoStack.push(reorderCommand);
 }
 
 void DrawingView::selectItemsCommand(const QList<DrawingItem*>& items, bool finalSelect,
@@ -2027,9 +2589,11 @@ void DrawingView::placeItems(const QList<DrawingItem*>& items, QUndoCommand* com
 
 	if (mScene)
 	{
+		QList<DrawingItem*> sceneItems = mScene->items();
+
 		for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
 		{
-			for(auto otherItemIter = mScene->mItems.begin(); otherItemIter != mScene->mItems.end(); otherItemIter++)
+			for(auto otherItemIter = sceneItems.begin(); otherItemIter != sceneItems.end(); otherItemIter++)
 			{
 				if ((*itemIter)->parent() == nullptr && !items.contains(*otherItemIter) && !mNewItems.contains(*otherItemIter))
 				{
@@ -2055,6 +2619,11 @@ void DrawingView::unplaceItems(const QList<DrawingItem*>& items, QUndoCommand* c
 	DrawingItem* item;
 	DrawingItemPoint* itemPoint;
 	QList<DrawingItemPoint*> itemPoints, targetPoints;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	QSet<DrawingItem*> itemSet(items.begin(), items.end());
+#else
+	QSet<DrawingItem*> itemSet = items.toSet();
+#endif
 
 	for(auto itemIter = items.begin(); itemIter != items.end(); itemIter++)
 	{
@@ -2067,7 +2636,7 @@ void DrawingView::unplaceItems(const QList<DrawingItem*>& items, QUndoCommand* c
 			targetPoints = itemPoint->connections();
 			for(auto targetPointIter = targetPoints.begin(); targetPointIter != targetPoints.end(); targetPointIter++)
 			{
-				if (!items.contains((*targetPointIter)->item()))
+				if (!itemSet.contains((*targetPointIter)->item()))
 					disconnectItemPointsCommand(itemPoint, *targetPointIter, command);
 			}
 		}
@@ -2196,10 +2765,272 @@ void DrawingView::recalculateContentSize(const QRectF& targetSceneRect)
 	mViewportTransform.scale(mScale, mScale);
 
 	mSceneTransform = mViewportTransform.inverted();
+
+	// A frame that is being rendered at a different zoom level would be discarded when finished
+	if (mRenderWatcher.isRunning() && mAsyncRenderTransform != mViewportTransform)
+		mAsyncRenderCancelled.store(1);
+}
+
+//==================================================================================================
+
+void DrawingView::renderTiles(QVector<RenderTile>& tiles, const QTransform& transform, const QColor& fillColor,
+	QPainter::RenderHints hints)
+{
+	// Items apply this view's level-of-detail settings while the tiles are rendered
+	if (mScene) mScene->mRenderView = this;
+
+	// Items draw text, which is only safe outside the GUI thread on some platforms
+	if (!(mFlags & SingleThreadedRendering) && tiles.size() > 1 && QThreadPool::globalInstance()->maxThreadCount() > 1 &&
+		QFontDatabase::supportsThreadedFontRendering())
+	{
+		// Items are only read while the tiles are rendered, so bring any state that items compute
+		// on demand up to date first
+		QRectF sceneRect;
+		QTransform sceneTransform = transform.inverted();
+
+		for(auto tileIter = tiles.begin(); tileIter != tiles.end(); tileIter++)
+			sceneRect = sceneRect.united(sceneTransform.mapRect(QRectF(tileIter->rect)));
+
+		if (mScene) mScene->prepareConcurrentRender(sceneRect);
+
+		QtConcurrent::blockingMap(tiles, [this, &transform, &fillColor, hints](RenderTile& tile) {
+			renderTile(tile, transform, fillColor, hints); });
+	}
+	else
+	{
+		for(auto tileIter = tiles.begin(); tileIter != tiles.end(); tileIter++)
+			renderTile(*tileIter, transform, fillColor, hints);
+	}
+
+	if (mScene) mScene->mRenderView = nullptr;
+}
+
+void DrawingView::renderTile(RenderTile& tile, const QTransform& transform, const QColor& fillColor,
+	QPainter::RenderHints hints)
+{
+	tile.image = QImage(tile.rect.size(), (fillColor.alpha() == 255) ?
+		QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied);
+	tile.image.fill(fillColor);
+
+	QPainter painter(&tile.image);
+
+	painter.translate(-tile.rect.left(), -tile.rect.top());
+	painter.setTransform(transform, true);
+	painter.setRenderHints(hints);
+
+	// Clip to the tile so that DrawingScene can skip items outside of it
+	painter.setClipRect(transform.inverted().mapRect(QRectF(tile.rect.adjusted(-1, -1, 1, 1))));
+
+	drawBackground(&painter);
+	drawItems(&painter);
+}
+
+void DrawingView::startAsynchronousRender(const QRect& contentRect)
+{
+	// Only one frame is rendered at a time; the next frame is started once it has been shown
+	if (mScene && !mRenderWatcher.isRunning() && mAsyncRenderTiles.isEmpty())
+	{
+		// Render every tile in the content rect that is missing or stale.  If the zoom level has
+		// changed, all of the tiles are rendered at the new zoom level.
+		bool zoomChanged = (mRenderTilesTransform != mViewportTransform);
+		QVector<RenderTile> tiles;
+		QRect frameRect;
+
+		int leftColumn = qFloor((qreal)contentRect.left() / renderTileSize);
+		int rightColumn = qFloor((qreal)contentRect.right() / renderTileSize);
+		int topRow = qFloor((qreal)contentRect.top() / renderTileSize);
+		int bottomRow = qFloor((qreal)contentRect.bottom() / renderTileSize);
+
+		for(int row = topRow; row <= bottomRow; row++)
+		{
+			for(int column = leftColumn; column <= rightColumn; column++)
+			{
+				quint64 tileKey = renderTileKey(column, row);
+
+				if (zoomChanged || !mRenderTiles.contains(tileKey) || mStaleRenderTiles.contains(tileKey))
+				{
+					RenderTile tile;
+					tile.rect = QRect(column * renderTileSize, row * renderTileSize, renderTileSize, renderTileSize);
+					tiles.append(tile);
+
+					frameRect = frameRect.united(tile.rect);
+				}
+			}
+		}
+
+		if (!tiles.isEmpty())
+		{
+			if (!mRenderPassTimer.isValid())
+			{
+				mRenderPassTimer.start();
+				mRenderPassTileCount = 0;
+			}
+
+			// Take a snapshot of the visible part of the scene on the GUI thread.  The snapshot
+			// shares each item's existing display list, and the background thread only reads it,
+			// so the scene is free to change while the tiles are rendered.  Only the background
+			// (and the overview, which is bounded by the density image) is recorded here.
+			QSharedPointer<DrawingSceneSnapshot> snapshot(new DrawingSceneSnapshot(mViewportTransform));
+			QRectF exposedRect = mViewportTransform.inverted().mapRect(QRectF(frameRect.adjusted(-1, -1, 1, 1)));
+			bool overview = (qSqrt(qAbs(mViewportTransform.determinant())) < mOverviewScale);
+
+			snapshot->setLevelOfDetail(mMinimumRenderPenWidth, mMinimumTextSize);
+
+			QPainter backgroundPainter(snapshot->background());
+			backgroundPainter.setTransform(mViewportTransform);
+			backgroundPainter.setClipRect(exposedRect);
+
+			mScene->mRenderView = this;
+			drawBackground(&backgroundPainter);
+			if (overview) drawItems(&backgroundPainter);
+			else mScene->snapshotItems(snapshot.data(), exposedRect);
+			mScene->mRenderView = nullptr;
+
+			backgroundPainter.end();
+
+			mAsyncRenderTransform = mViewportTransform;
+			mAsyncRenderStale = false;
+			mAsyncRenderReduced = mInteractionActive;
+			mAsyncRenderCancelled.store(0);
+			mAsyncRenderTiles.clear();
+			for(auto tileIter = tiles.begin(); tileIter != tiles.end(); tileIter++)
+			{
+				quint64 tileKey = renderTileKey(tileIter->rect.left() / renderTileSize,
+					tileIter->rect.top() / renderTileSize);
+
+				mAsyncRenderTiles.insert(tileKey);
+				mStaleRenderTiles.remove(tileKey);
+			}
+
+			mRenderWatcher.setFuture(QtConcurrent::run(&DrawingView::renderFrame, tiles, snapshot,
+				palette().brush(QPalette::Window).color(), renderQualityHints(), &mAsyncRenderCancelled));
+		}
+	}
+}
+
+QVector<DrawingView::RenderTile> DrawingView::renderFrame(QVector<RenderTile> tiles,
+	QSharedPointer<DrawingSceneSnapshot> snapshot, QColor fillColor, QPainter::RenderHints hints,
+	const QAtomicInt* cancelled)
+{
+	// Stop between tiles once the frame is no longer needed; finishAsynchronousRender() discards
+	// a cancelled frame
+	for(auto tileIter = tiles.begin(); tileIter != tiles.end() && !cancelled->load(); tileIter++)
+	{
+		tileIter->image = QImage(tileIter->rect.size(), (fillColor.alpha() == 255) ?
+			QImage::Format_RGB32 : QImage::Format_ARGB32_Premultiplied);
+		tileIter->image.fill(fillColor);
+
+		QPainter painter(&tileIter->image);
+		painter.translate(-tileIter->rect.left(), -tileIter->rect.top());
+		painter.setRenderHints(hints);
+
+		// Only the items that overlap the tile are drawn
+		snapshot->draw(&painter, QRectF(tileIter->rect.adjusted(-1, -1, 1, 1)));
+	}
+
+	return tiles;
+}
+
+void DrawingView::invalidateRenderTile(quint64 tileKey)
+{
+	// With asynchronous rendering, the previous image of the tile is shown until the new one has
+	// been rendered
+	if (usesAsynchronousRendering())
+	{
+		if (mRenderTiles.contains(tileKey) || mAsyncRenderTiles.contains(tileKey))
+			mStaleRenderTiles.insert(tileKey);
+	}
+	else mRenderTiles.remove(tileKey);
+}
+
+bool DrawingView::usesAsynchronousRendering() const
+{
+	// Items draw text, which is only safe outside the GUI thread on some platforms.  Otherwise
+	// the tiles are rendered in paintEvent() as if the flag was not set.
+	return ((mFlags & AsynchronousRendering) && QFontDatabase::supportsThreadedFontRendering());
+}
+
+quint64 DrawingView::renderTileKey(int column, int row)
+{
+	return ((quint64)(quint32)column << 32) | (quint64)(quint32)row;
+}
+
+void DrawingView::beginInteraction()
+{
+	if (mFlags & AdaptiveAntialiasing)
+	{
+		mInteractionActive = true;
+		mInteractionTimer.start();
+	}
+}
+
+QPainter::RenderHints DrawingView::renderQualityHints() const
+{
+	// Antialiasing roughly doubles the cost of rasterizing dense line art, so it is skipped while
+	// the user is interacting with the view.  Text antialiasing is much cheaper and is kept.
+	QPainter::RenderHints hints = QPainter::TextAntialiasing;
+	if (!mInteractionActive) hints |= QPainter::Antialiasing;
+	return hints;
+}
+
+void DrawingView::drawZoomPreview(QPainter* painter, const QPoint& scrollOffset)
+{
+	// Map the cached tiles from the content area at their zoom level to the content area at the
+	// current zoom level
+	QTransform previewTransform = mRenderTilesTransform.inverted() * mViewportTransform;
+
+	painter->save();
+
+	// Parts of the viewport that were not covered by any tile are left empty until the scene is
+	// rendered at the new zoom level
+	painter->fillRect(viewport()->rect(), palette().brush(QPalette::Window));
+
+	painter->translate(-scrollOffset);
+	painter->setTransform(previewTransform, true);
+
+	QRectF exposedRect = painter->transform().inverted().mapRect(QRectF(viewport()->rect()));
+	QList<quint64> tileKeys = mRenderTiles.keys();
+
+	for(auto keyIter = tileKeys.begin(); keyIter != tileKeys.end(); keyIter++)
+	{
+		int column = (qint32)(*keyIter >> 32);
+		int row = (qint32)(*keyIter & 0xFFFFFFFF);
+		QRect tileRect(column * renderTileSize, row * renderTileSize, renderTileSize, renderTileSize);
+		QImage* tileImage = mRenderTiles.object(*keyIter);
+
+		if (tileImage && exposedRect.intersects(tileRect))
+			painter->drawImage(tileRect.topLeft(), *tileImage);
+	}
+
+	painter->restore();
 }
 
 //==================================================================================================
 
+QList<DrawingItem*> DrawingView::selectedItemsInOrder(QHash<DrawingItem*,int>& itemIndex) const
+{
+	QList<DrawingItem*> items;
+
+	for(auto itemIter = mSelectedItems.begin(); itemIter != mSelectedItems.end(); itemIter++)
+	{
+		if ((*itemIter)->parent() == nullptr) items.append(*itemIter);
+	}
+
+	itemIndex = mScene->itemIndices(items);
+
+	// Drop any items that are not in the scene and sort the rest by their index in the scene
+	for(auto itemIter = items.begin(); itemIter != items.end(); )
+	{
+		if (itemIndex.contains(*itemIter)) itemIter++;
+		else itemIter = items.erase(itemIter);
+	}
+
+	std::sort(items.begin(), items.end(), [&itemIndex](DrawingItem* item1, DrawingItem* item2) {
+		return itemIndex.value(item1) < itemIndex.value(item2); });
+
+	return items;
+}
+
 qreal DrawingView::minimumPenWidth(DrawingItem* item) const
 {
 	const qreal penWidthHint = 8;